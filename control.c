@@ -0,0 +1,122 @@
+/*
+    control.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "control.h"
+
+static const struct {
+  const char *name;
+  int cmd;
+} commands[] = {
+  { "reload", CTL_RELOAD },
+  { "update", CTL_UPDATE },
+  { "alarm", CTL_ALARM },
+  { "log", CTL_LOG },
+  { NULL, CTL_UNKNOWN }
+};
+
+static int fd = -1;
+static char buf[CONTROL_LINE_MAX];
+static int len;
+static int skipping;           /* in the middle of an overlong line */
+static char line[CONTROL_LINE_MAX];
+
+/*****************************************************************************/
+/* Opens (making it if need be) the control FIFO. We hold it open for
+   writing as well, so it never reads as closed between writers. */
+int control_open(const char *fifo)
+{
+  if (mkfifo(fifo, 0600) && errno != EEXIST)
+    return -1;
+  if ((fd = open(fifo, O_RDONLY | O_NONBLOCK)) < 0)
+    return -1;
+  if (open(fifo, O_WRONLY | O_NONBLOCK) < 0) {
+    close(fd);
+    fd = -1;
+    return -1;
+  }
+  return 0;
+}
+
+/* Fills in pfd so poll() wakes for commands. Returns 1, or 0 without a
+   control FIFO. */
+int control_pollfd(struct pollfd *pfd)
+{
+  if (fd < 0)
+    return 0;
+  pfd->fd = fd;
+  pfd->events = POLLIN;
+  pfd->revents = 0;
+  return 1;
+}
+
+/* Returns the next complete command, or CTL_NONE. *arg is set to what
+   follows the command word, and stays good until the next call. */
+int control_next(const char **arg)
+{
+  char *nl, *p;
+  int n, i;
+
+  if (fd < 0)
+    return CTL_NONE;
+  for (;;) {
+    if ((nl = memchr(buf, '\n', len))) {
+      *nl = '\0';
+      n = nl - buf + 1;
+      if (!skipping)
+	strcpy(line, buf);
+      memmove(buf, buf + n, len - n);
+      len -= n;
+      if (skipping) {
+	skipping = 0;
+	continue;
+      }
+      break;
+    }
+    if (len == sizeof(buf)) {
+      /* Too long to be a command; throw it away up to its newline */
+      skipping = 1;
+      len = 0;
+    }
+    if ((n = read(fd, buf + len, sizeof(buf) - len)) <= 0)
+      return CTL_NONE;
+    len += n;
+  }
+
+  for (n = strlen(line); n && strchr(" \t\r", line[n - 1]); n--)
+    line[n - 1] = '\0';
+  for (p = line; *p && *p != ' ' && *p != '\t'; p++)
+    ;
+  n = p - line;
+  while (*p == ' ' || *p == '\t')
+    p++;
+  *arg = p;
+  if (!n)
+    return control_next(arg);  /* blank line */
+  for (i = 0; commands[i].name; i++)
+    if ((int)strlen(commands[i].name) == n && !strncmp(line, commands[i].name, n))
+      break;
+  return commands[i].cmd;
+}
@@ -0,0 +1,50 @@
+/*
+    control.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_CONTROL_H
+#define WMSENSORS_CONTROL_H
+
+#include <poll.h>
+
+/*************************************************************************/
+/* Commands written to the -C control FIFO, one per line, eg.            */
+/*   echo 'update 2' > /tmp/wmsensors.ctl                                */
+/* They are picked up by the main loop, so they always take effect      */
+/* between updates.                                                      */
+/*                                                                       */
+/*   reload            re-read sensors.conf (as SIGHUP does)            */
+/*   update <secs>     change the update speed                           */
+/*   alarm [command]   change the alarm command, or turn alarms off      */
+/*   log <file>|-|off  start a new -r log, on stdout, or stop logging    */
+/*************************************************************************/
+
+#define CONTROL_LINE_MAX 1024
+
+#define CTL_NONE    0          /* no complete command waiting */
+#define CTL_RELOAD  1
+#define CTL_UPDATE  2
+#define CTL_ALARM   3
+#define CTL_LOG     4
+#define CTL_UNKNOWN 5
+
+int control_open(const char *fifo);
+int control_pollfd(struct pollfd *pfd);
+int control_next(const char **arg);
+
+#endif /* WMSENSORS_CONTROL_H */
@@ -0,0 +1,128 @@
+/*
+    graph.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <string.h>
+#include "graph.h"
+
+const char *graph_colours[NGRAPH_COLOURS] = {
+  "Q c #ff0000", "R c #00ff00", "S c #c4c4c4", "T c #d000ff",
+  "U c #00ffff", "V c #ff7f00", "W c #ffff00"
+};
+
+/* The grey lines where the normal values of the parameters lie */
+const int graph_guides_left[NGUIDES_LEFT] = { 11, 21, 31, 42, 52 };
+const int graph_guides_right[NGUIDES_RIGHT] = { 10, 18, 26, 35, 44, 53 };
+
+static void add(struct graph_point *p, int *n, int channel, int x, int level,
+		int colour)
+{
+  p[*n].x = x;
+  p[*n].y = 58 - level;
+  p[*n].colour = colour;
+  p[*n].channel = channel;
+  (*n)++;
+}
+
+/* Returns the channels drawn by the layout called name ("all", "temp",
+   "volt" or "fan"), or 0 if there is no such layout */
+int graph_layout(const char *name)
+{
+  static const struct {
+    const char *name;
+    int channels;
+  } layouts[] = {
+    { "all", LAYOUT_ALL }, { "temp", LAYOUT_TEMP },
+    { "volt", LAYOUT_VOLT }, { "fan", LAYOUT_FAN }, { NULL, 0 }
+  };
+  int i;
+
+  for (i = 0; layouts[i].name && strcmp(name, layouts[i].name); i++)
+    ;
+  return layouts[i].channels;
+}
+
+/*****************************************************************************/
+/* Works out the points to plot for one sample, in the order they are
+   drawn (later points cover earlier ones). p must have room for
+   NCHANNELS points. Returns the number of points. */
+int graph_points(const struct sample *s, const struct limits *l,
+		 int multiple_lm75, struct graph_point *p)
+{
+  const double *v = s->v;
+  const double *lo = l->lo, *hi = l->hi;
+  int temp1p, temp2p, temp3p, in0p, in1p, in2p, in3p, in4p, in5p, in6p;
+  int fan1p, fan2p, fan3p;
+  int n = 0;
+
+  /* Convert data into actual pixel values */
+  /* Temperatures (for left-hand column) */
+  temp2p=((v[CH_TEMP2]-l->temp_base)/3)+42;
+  temp3p=((v[CH_TEMP3]-l->temp_base)/3)+42;
+  temp1p=((v[CH_TEMP1]-l->temp_base)/3)+42;
+  /* Safety checks on temperature levels */
+  if (temp1p > 52) temp1p = 51;
+  if (temp2p > 52) temp2p = 51;
+  if (temp3p > 52) temp3p = 51;
+
+  /* Left hand column */
+  in3p=32+(((v[CH_IN3]-lo[CH_IN3])/(hi[CH_IN3]-lo[CH_IN3]))*(43-32));
+  in6p=23+(((v[CH_IN6]-lo[CH_IN6])/(hi[CH_IN6]-lo[CH_IN6]))*(32-23));
+  in4p=11+(((v[CH_IN4]-lo[CH_IN4])/(hi[CH_IN4]-lo[CH_IN4]))*(22-11));
+  in5p= 1+(((v[CH_IN5]-lo[CH_IN5])/(hi[CH_IN5]-lo[CH_IN5]))*(22-12));
+
+  /* Right hand column */
+  in0p=44+(((v[CH_IN0]-lo[CH_IN0])/(hi[CH_IN0]-lo[CH_IN0]))*(53-44));
+  in1p=37+(((v[CH_IN1]-lo[CH_IN1])/(hi[CH_IN1]-lo[CH_IN1]))*(44-36));
+  in2p=29+(((v[CH_IN2]-lo[CH_IN2])/(hi[CH_IN2]-lo[CH_IN2]))*(36-29));
+
+  fan1p=(v[CH_FAN1]/625)+19;
+  fan2p=(v[CH_FAN2]/625)+10;
+  fan3p=(v[CH_FAN3]/625)+1;
+
+  /* CPU temps and motherboard temp */
+  if (v[CH_TEMP2] > -100)
+    add(p, &n, CH_TEMP2, GRAPH_LEFT, temp2p, 6);
+  if (multiple_lm75 && v[CH_TEMP3] > -100)
+    add(p, &n, CH_TEMP3, GRAPH_LEFT, temp3p, 6);
+  if (v[CH_TEMP1] > -100)
+    add(p, &n, CH_TEMP1, GRAPH_LEFT, temp1p, 6);
+
+  if (v[CH_IN0] > -100)
+    add(p, &n, CH_IN0, GRAPH_RIGHT, in0p, 17);
+  if (v[CH_IN1] > -100)
+    add(p, &n, CH_IN1, GRAPH_RIGHT, in1p, 18);
+  if (v[CH_IN2] > -100)
+    add(p, &n, CH_IN2, GRAPH_RIGHT, in2p, 15);
+  if (v[CH_IN3] > -100)
+    add(p, &n, CH_IN3, GRAPH_LEFT, in3p, 9);
+  if (v[CH_IN6] > -100)
+    add(p, &n, CH_IN6, GRAPH_LEFT, in6p, 10);
+  if (v[CH_IN4] > -100)
+    add(p, &n, CH_IN4, GRAPH_LEFT, in4p, 11);
+  if (v[CH_IN5] > -100)
+    add(p, &n, CH_IN5, GRAPH_LEFT, in5p, 12);
+
+  if (fan1p > 20)
+    add(p, &n, CH_FAN1, GRAPH_RIGHT, fan1p, 13);
+  if (fan2p > 11)
+    add(p, &n, CH_FAN2, GRAPH_RIGHT, fan2p, 14);
+  if (fan3p > 1)
+    add(p, &n, CH_FAN3, GRAPH_RIGHT, fan3p, 19);
+  return n;
+}
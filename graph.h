@@ -0,0 +1,74 @@
+/*
+    graph.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_GRAPH_H
+#define WMSENSORS_GRAPH_H
+
+#include "sample.h"
+
+/*************************************************************************/
+/* Where each reading goes on the graphs. Positions are in the 64x64     */
+/* back.xpm (unshaped) coordinates; colours are given as the x of their  */
+/* cell in row GRAPH_COLOUR_ROW of back.xpm, where GetXPM() puts them.   */
+/* Anything that draws the graphs, on screen or off, should go through   */
+/* here so they all look the same.                                       */
+/*************************************************************************/
+
+#define GRAPH_TOP        6     /* first row of the graph area */
+#define GRAPH_BOTTOM     57    /* and the last */
+#define GRAPH_LEFT       31    /* newest column of the left hand graphs */
+#define GRAPH_RIGHT      57    /* newest column of the right hand graphs */
+#define GRAPH_DIVIDER    32    /* the line down the middle */
+
+#define GRAPH_COLOUR_ROW 6
+#define GRAPH_GUIDE_COLOUR   16
+#define GRAPH_DIVIDER_COLOUR 8
+#define GRAPH_BLANK_COLOUR   20
+#define GRAPH_STALE_COLOUR   GRAPH_GUIDE_COLOUR
+
+#define NGUIDES_LEFT  5
+#define NGUIDES_RIGHT 6
+
+/* The colours GetXPM() puts over back_xpm[GRAPH_COLOURS_AT] onwards */
+#define NGRAPH_COLOURS 7
+#define GRAPH_COLOURS_AT 45
+
+/* Which channels a view draws, a bit (1 << CH_...) for each */
+#define LAYOUT_ALL  ((1 << NCHANNELS) - 1)
+#define LAYOUT_TEMP ((1 << CH_TEMP1) | (1 << CH_TEMP2) | (1 << CH_TEMP3))
+#define LAYOUT_VOLT ((1 << CH_IN0) | (1 << CH_IN1) | (1 << CH_IN2) \
+		     | (1 << CH_IN3) | (1 << CH_IN4) | (1 << CH_IN5) \
+		     | (1 << CH_IN6))
+#define LAYOUT_FAN  ((1 << CH_FAN1) | (1 << CH_FAN2) | (1 << CH_FAN3))
+
+struct graph_point {
+  int x, y;                    /* where */
+  int colour;                  /* x of the colour cell */
+  int channel;                 /* what it shows */
+};
+
+extern const char *graph_colours[NGRAPH_COLOURS];
+extern const int graph_guides_left[NGUIDES_LEFT];
+extern const int graph_guides_right[NGUIDES_RIGHT];
+
+int graph_layout(const char *name);
+int graph_points(const struct sample *s, const struct limits *l,
+		 int multiple_lm75, struct graph_point *p);
+
+#endif /* WMSENSORS_GRAPH_H */
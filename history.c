@@ -0,0 +1,567 @@
+/*
+    history.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "history.h"
+
+/*****************************************************************************/
+/* Bit level helpers. Bits are packed most significant first. */
+
+static void put_bits(unsigned char *d, unsigned long *pos, uint64_t v, int n)
+{
+  int off, room, take;
+
+  while (n > 0) {
+    off = *pos & 7;
+    room = 8 - off;
+    take = n < room ? n : room;
+    d[*pos >> 3] |= ((v >> (n - take)) & ((1u << take) - 1)) << (room - take);
+    *pos += take;
+    n -= take;
+  }
+}
+
+static uint64_t get_bits(const unsigned char *d, unsigned long *pos, int n)
+{
+  uint64_t v = 0;
+  int off, room, take;
+
+  while (n > 0) {
+    off = *pos & 7;
+    room = 8 - off;
+    take = n < room ? n : room;
+    v = (v << take) | ((d[*pos >> 3] >> (room - take)) & ((1u << take) - 1));
+    *pos += take;
+    n -= take;
+  }
+  return v;
+}
+
+static uint64_t double_bits(double d)
+{
+  uint64_t u;
+
+  memcpy(&u, &d, sizeof(u));
+  return u;
+}
+
+static double bits_double(uint64_t u)
+{
+  double d;
+
+  memcpy(&d, &u, sizeof(d));
+  return d;
+}
+
+/*****************************************************************************/
+/* Encoder */
+
+void hist_block_init(struct hist_block *b)
+{
+  int c;
+
+  b->t0 = b->t1 = 0;
+  b->n = 0;
+  b->nbits = 0;
+  b->delta = 0;
+  memset(b->data, 0, sizeof(b->data));
+  for (c = 0; c < NCHANNELS; c++) {
+    b->min[c] = HUGE_VAL;
+    b->max[c] = -HUGE_VAL;
+    b->prev[c] = 0;
+    b->lead[c] = -1;
+    b->trail[c] = 0;
+  }
+}
+
+/* Timestamps: delta-of-delta in one of five buckets */
+static void put_time(struct hist_block *b, time_t t)
+{
+  long delta = (long)(t - b->t1);
+  long dod = delta - b->delta;
+
+  if (dod == 0)
+    put_bits(b->data, &b->nbits, 0, 1);
+  else if (dod >= -63 && dod <= 64) {
+    put_bits(b->data, &b->nbits, 2, 2);
+    put_bits(b->data, &b->nbits, dod + 63, 7);
+  } else if (dod >= -255 && dod <= 256) {
+    put_bits(b->data, &b->nbits, 6, 3);
+    put_bits(b->data, &b->nbits, dod + 255, 9);
+  } else if (dod >= -2047 && dod <= 2048) {
+    put_bits(b->data, &b->nbits, 14, 4);
+    put_bits(b->data, &b->nbits, dod + 2047, 12);
+  } else {
+    put_bits(b->data, &b->nbits, 15, 4);
+    put_bits(b->data, &b->nbits, (uint32_t)dod, 32);
+  }
+  b->delta = delta;
+  b->t1 = t;
+}
+
+/* Values: XOR with the previous reading, reusing the previous window of
+   meaningful bits when the new one fits inside it */
+static void put_value(struct hist_block *b, int c, double v)
+{
+  uint64_t u = double_bits(v);
+  uint64_t x = u ^ b->prev[c];
+  int lead, trail, len;
+
+  b->prev[c] = u;
+  if (!x) {
+    put_bits(b->data, &b->nbits, 0, 1);
+    return;
+  }
+  lead = __builtin_clzll(x);
+  trail = __builtin_ctzll(x);
+  if (lead > 31)
+    lead = 31;
+  if (b->lead[c] >= 0 && lead >= b->lead[c] && trail >= b->trail[c]) {
+    len = 64 - b->lead[c] - b->trail[c];
+    put_bits(b->data, &b->nbits, 2, 2);
+    put_bits(b->data, &b->nbits, x >> b->trail[c], len);
+  } else {
+    len = 64 - lead - trail;
+    put_bits(b->data, &b->nbits, 3, 2);
+    put_bits(b->data, &b->nbits, lead, 5);
+    put_bits(b->data, &b->nbits, len - 1, 6);
+    put_bits(b->data, &b->nbits, x >> trail, len);
+    b->lead[c] = lead;
+    b->trail[c] = trail;
+  }
+}
+
+/* Adds s to the block. Returns -1, leaving the block untouched, if it is
+   full. */
+int hist_block_append(struct hist_block *b, const struct sample *s)
+{
+  int c;
+
+  if (b->n >= HIST_BLOCK_SAMPLES
+      || b->nbits + HIST_SAMPLE_MAXBITS > HIST_BLOCK_BYTES * 8)
+    return -1;
+
+  if (b->n == 0) {
+    b->t0 = b->t1 = s->t;
+    for (c = 0; c < NCHANNELS; c++) {
+      b->prev[c] = double_bits(s->v[c]);
+      put_bits(b->data, &b->nbits, b->prev[c], 64);
+    }
+  } else {
+    put_time(b, s->t);
+    for (c = 0; c < NCHANNELS; c++)
+      put_value(b, c, s->v[c]);
+  }
+  for (c = 0; c < NCHANNELS; c++) {
+    if (s->v[c] == NO_READING)
+      continue;
+    if (s->v[c] < b->min[c])
+      b->min[c] = s->v[c];
+    if (s->v[c] > b->max[c])
+      b->max[c] = s->v[c];
+  }
+  b->n++;
+  return 0;
+}
+
+int hist_block_bytes(const struct hist_block *b)
+{
+  return (b->nbits + 7) / 8;
+}
+
+/*****************************************************************************/
+/* Decoder */
+
+void hist_reader_init(struct hist_reader *r, const struct hist_block *b)
+{
+  int c;
+
+  r->b = b;
+  r->pos = 0;
+  r->i = 0;
+  r->delta = 0;
+  for (c = 0; c < NCHANNELS; c++) {
+    r->lead[c] = -1;
+    r->trail[c] = 0;
+  }
+}
+
+/* get_bits() that stops at the end of the block. Running past it, or
+   asking for more than 64 bits, marks the reader as damaged by moving it
+   past the end for good. */
+static uint64_t take_bits(struct hist_reader *r, int n)
+{
+  if (n < 0 || n > 64 || r->pos + n > r->b->nbits) {
+    r->pos = r->b->nbits + 1;
+    return 0;
+  }
+  return get_bits(r->b->data, &r->pos, n);
+}
+
+static long get_dod(struct hist_reader *r)
+{
+  int ones = 0;
+
+  while (ones < 4 && take_bits(r, 1))
+    ones++;
+  switch (ones) {
+  case 0:
+    return 0;
+  case 1:
+    return (long)take_bits(r, 7) - 63;
+  case 2:
+    return (long)take_bits(r, 9) - 255;
+  case 3:
+    return (long)take_bits(r, 12) - 2047;
+  default:
+    return (int32_t)take_bits(r, 32);
+  }
+}
+
+static double get_value(struct hist_reader *r, int c)
+{
+  uint64_t u = double_bits(r->s.v[c]);
+  int len;
+
+  if (!take_bits(r, 1))
+    return r->s.v[c];
+  if (take_bits(r, 1)) {
+    r->lead[c] = take_bits(r, 5);
+    len = take_bits(r, 6) + 1;
+    r->trail[c] = 64 - r->lead[c] - len;
+  } else
+    len = 64 - r->lead[c] - r->trail[c];
+  if (r->lead[c] < 0 || r->trail[c] < 0) {
+    take_bits(r, -1);          /* no window to reuse, or one that won't fit */
+    return r->s.v[c];
+  }
+  u ^= take_bits(r, len) << r->trail[c];
+  return bits_double(u);
+}
+
+/* Fetches the next sample of the block into s. Returns 0 at the end, and
+   -1 if the block is damaged: its samples need more bits than it has. */
+int hist_reader_next(struct hist_reader *r, struct sample *s)
+{
+  int c;
+
+  if (r->pos > r->b->nbits)
+    return -1;
+  if (r->i >= r->b->n)
+    return 0;
+  if (r->i == 0) {
+    r->s.t = r->b->t0;
+    for (c = 0; c < NCHANNELS; c++)
+      r->s.v[c] = bits_double(take_bits(r, 64));
+  } else {
+    r->delta += get_dod(r);
+    r->s.t += r->delta;
+    for (c = 0; c < NCHANNELS; c++)
+      r->s.v[c] = get_value(r, c);
+  }
+  if (r->pos > r->b->nbits)
+    return -1;
+  r->i++;
+  *s = r->s;
+  return 1;
+}
+
+/*****************************************************************************/
+/* On-disk format: HIST_FILE_MAGIC, then blocks. A block is a 20 byte
+   little-endian header (t0, t1, sample count, data length) followed by its
+   data. */
+
+static void put_le(unsigned char *p, uint64_t v, int n)
+{
+  while (n--) {
+    *p++ = v & 0xff;
+    v >>= 8;
+  }
+}
+
+static uint64_t get_le(const unsigned char *p, int n)
+{
+  uint64_t v = 0;
+
+  while (n--)
+    v = (v << 8) | p[n];
+  return v;
+}
+
+int hist_file_write_header(FILE *f)
+{
+  return fwrite(HIST_FILE_MAGIC, HIST_FILE_MAGIC_LEN, 1, f) == 1 ? 0 : -1;
+}
+
+int hist_file_check_header(FILE *f)
+{
+  char magic[HIST_FILE_MAGIC_LEN];
+
+  if (fread(magic, HIST_FILE_MAGIC_LEN, 1, f) != 1
+      || memcmp(magic, HIST_FILE_MAGIC, HIST_FILE_MAGIC_LEN))
+    return -1;
+  return 0;
+}
+
+int hist_block_write(FILE *f, const struct hist_block *b)
+{
+  unsigned char head[HIST_BLOCK_HEADER_LEN];
+  int len = hist_block_bytes(b);
+
+  put_le(head, (int64_t)b->t0, 8);
+  put_le(head + 8, (int64_t)b->t1, 8);
+  put_le(head + 16, b->n, 2);
+  put_le(head + 18, len, 2);
+  if (fwrite(head, sizeof(head), 1, f) != 1
+      || (len && fwrite(b->data, len, 1, f) != 1))
+    return -1;
+  return 0;
+}
+
+/* Reads the next block. Returns 0 on success, 1 at end of file and -1 if
+   the file is damaged. Only enough is filled in to decode the block; a
+   block whose data is damaged shows when hist_reader_next() runs out of
+   bits. */
+int hist_block_read(FILE *f, struct hist_block *b)
+{
+  unsigned char head[HIST_BLOCK_HEADER_LEN];
+  int len;
+
+  if (fread(head, sizeof(head), 1, f) != 1)
+    return feof(f) ? 1 : -1;
+  b->t0 = (int64_t)get_le(head, 8);
+  b->t1 = (int64_t)get_le(head + 8, 8);
+  b->n = get_le(head + 16, 2);
+  len = get_le(head + 18, 2);
+  if (len > HIST_BLOCK_BYTES || b->n > HIST_BLOCK_SAMPLES)
+    return -1;
+  if (len && fread(b->data, len, 1, f) != 1)
+    return -1;
+  b->nbits = len * 8;
+  return 0;
+}
+
+/* Works out the per-channel summaries of a block read back from disk */
+void hist_block_summarise(struct hist_block *b)
+{
+  struct hist_reader r;
+  struct sample s;
+  int c;
+
+  for (c = 0; c < NCHANNELS; c++) {
+    b->min[c] = HUGE_VAL;
+    b->max[c] = -HUGE_VAL;
+  }
+  hist_reader_init(&r, b);
+  while (hist_reader_next(&r, &s) > 0)
+    for (c = 0; c < NCHANNELS; c++) {
+      if (s.v[c] == NO_READING)
+	continue;
+      if (s.v[c] < b->min[c])
+	b->min[c] = s.v[c];
+      if (s.v[c] > b->max[c])
+	b->max[c] = s.v[c];
+    }
+}
+
+/*****************************************************************************/
+/* The index: HIST_INDEX_MAGIC, then HIST_INDEX_ENTRY_LEN byte entries of
+   t0, t1, offset, sample count, 4 reserved bytes and the minima and maxima
+   as little-endian doubles. */
+
+int hist_index_write_header(FILE *f)
+{
+  return fwrite(HIST_INDEX_MAGIC, HIST_FILE_MAGIC_LEN, 1, f) == 1 ? 0 : -1;
+}
+
+int hist_index_append(FILE *f, const struct hist_block *b, long offset)
+{
+  unsigned char e[HIST_INDEX_ENTRY_LEN];
+  int c;
+
+  memset(e, 0, sizeof(e));
+  put_le(e, (int64_t)b->t0, 8);
+  put_le(e + 8, (int64_t)b->t1, 8);
+  put_le(e + 16, offset, 8);
+  put_le(e + 24, b->n, 4);
+  for (c = 0; c < NCHANNELS; c++) {
+    put_le(e + 32 + c * 8, double_bits(b->min[c]), 8);
+    put_le(e + 32 + (NCHANNELS + c) * 8, double_bits(b->max[c]), 8);
+  }
+  return fwrite(e, sizeof(e), 1, f) == 1 ? 0 : -1;
+}
+
+long hist_index_count(FILE *f)
+{
+  long len;
+
+  if (fseek(f, 0, SEEK_END) || (len = ftell(f)) < HIST_FILE_MAGIC_LEN)
+    return 0;
+  return (len - HIST_FILE_MAGIC_LEN) / HIST_INDEX_ENTRY_LEN;
+}
+
+int hist_index_read(FILE *f, long i, struct hist_index_entry *ent)
+{
+  unsigned char e[HIST_INDEX_ENTRY_LEN];
+  int c;
+
+  if (fseek(f, HIST_FILE_MAGIC_LEN + i * HIST_INDEX_ENTRY_LEN, SEEK_SET)
+      || fread(e, sizeof(e), 1, f) != 1)
+    return -1;
+  ent->t0 = (int64_t)get_le(e, 8);
+  ent->t1 = (int64_t)get_le(e + 8, 8);
+  ent->offset = get_le(e + 16, 8);
+  ent->n = get_le(e + 24, 4);
+  for (c = 0; c < NCHANNELS; c++) {
+    ent->min[c] = bits_double(get_le(e + 32 + c * 8, 8));
+    ent->max[c] = bits_double(get_le(e + 32 + (NCHANNELS + c) * 8, 8));
+  }
+  return 0;
+}
+
+/* Returns the first of count entries that ends at or after t, or count if
+   there is none */
+long hist_index_find(FILE *f, long count, time_t t)
+{
+  struct hist_index_entry e;
+  long lo = 0, hi = count, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (hist_index_read(f, mid, &e))
+      return count;
+    if (e.t1 < t)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Appends an entry for every block of hist to index */
+int hist_index_rebuild(FILE *hist, FILE *index)
+{
+  struct hist_block *b;
+  long offset;
+  int res;
+
+  if (!(b = malloc(sizeof(*b))))
+    return -1;
+  if (fseek(hist, 0, SEEK_SET) || hist_file_check_header(hist)) {
+    free(b);
+    return -1;
+  }
+  for (;;) {
+    offset = ftell(hist);
+    if ((res = hist_block_read(hist, b)))
+      break;
+    hist_block_summarise(b);
+    if (hist_index_append(index, b, offset)) {
+      res = -1;
+      break;
+    }
+  }
+  free(b);
+  fflush(index);
+  return res < 0 ? -1 : 0;
+}
+
+/* Opens the index belonging to histname */
+FILE *hist_index_open(const char *histname, const char *mode)
+{
+  char *name;
+  FILE *f;
+
+  if (!(name = malloc(strlen(histname) + sizeof(HIST_INDEX_SUFFIX))))
+    return NULL;
+  strcpy(name, histname);
+  strcat(name, HIST_INDEX_SUFFIX);
+  f = fopen(name, mode);
+  free(name);
+  return f;
+}
+
+/*****************************************************************************/
+/* A hist_store fills one block at a time in memory and, if it was given a
+   file, appends every finished block to it. */
+
+int hist_store_open(struct hist_store *h, const char *filename)
+{
+  h->file = NULL;
+  h->index = NULL;
+  hist_block_init(&h->cur);
+  if (!filename)
+    return 0;
+  if (!(h->file = fopen(filename, "a+b"))
+      || !(h->index = hist_index_open(filename, "a+b")))
+    goto fail;
+  fseek(h->file, 0, SEEK_END);
+  if (ftell(h->file) == 0 && hist_file_write_header(h->file))
+    goto fail;
+  fflush(h->file);
+  /* A missing index is rebuilt from the history */
+  fseek(h->index, 0, SEEK_END);
+  if (ftell(h->index) == 0
+      && (hist_index_write_header(h->index)
+	  || hist_index_rebuild(h->file, h->index)))
+    goto fail;
+  return 0;
+
+ fail:
+  if (h->file)
+    fclose(h->file);
+  if (h->index)
+    fclose(h->index);
+  h->file = h->index = NULL;
+  return -1;
+}
+
+/* Writes the current block out and starts a new one */
+static void finish_block(struct hist_store *h)
+{
+  long offset;
+
+  if (h->file) {
+    fseek(h->file, 0, SEEK_END);
+    offset = ftell(h->file);
+    hist_block_write(h->file, &h->cur);
+    fflush(h->file);
+    hist_index_append(h->index, &h->cur, offset);
+    fflush(h->index);
+  }
+  hist_block_init(&h->cur);
+}
+
+void hist_store_append(struct hist_store *h, const struct sample *s)
+{
+  if (hist_block_append(&h->cur, s)) {
+    finish_block(h);
+    hist_block_append(&h->cur, s);
+  }
+}
+
+/* Closes off the partly filled block, eg. before exiting */
+void hist_store_flush(struct hist_store *h)
+{
+  if (h->cur.n)
+    finish_block(h);
+}
@@ -0,0 +1,119 @@
+/*
+    history.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_HISTORY_H
+#define WMSENSORS_HISTORY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "sample.h"
+
+/*************************************************************************/
+/* Compressed sample history.                                            */
+/*                                                                       */
+/* Samples are packed into blocks of at most HIST_BLOCK_SAMPLES. Inside  */
+/* a block timestamps are stored as delta-of-deltas (a regular tick      */
+/* costs one bit) and each channel as the XOR of its double with the     */
+/* previous one (an unchanged reading costs one bit). Every block starts */
+/* from scratch, so any block can be decoded without its neighbours.     */
+/*************************************************************************/
+
+#define HIST_BLOCK_SAMPLES 256
+#define HIST_BLOCK_BYTES   4096
+
+/* Worst case bits for one sample: a 36 bit timestamp and 77 bit values */
+#define HIST_SAMPLE_MAXBITS (36 + NCHANNELS * 77)
+
+#define HIST_FILE_MAGIC "WMSHIST1"
+#define HIST_FILE_MAGIC_LEN 8
+#define HIST_BLOCK_HEADER_LEN 20
+
+/*************************************************************************/
+/* Each history file has an index beside it (the same name plus .idx)   */
+/* with one fixed size entry per block: its time span, where it starts  */
+/* and the smallest and largest reading of every channel. Queries find  */
+/* their first block by binary search and skip blocks whose summaries   */
+/* can't match without reading them.                                     */
+/*************************************************************************/
+
+#define HIST_INDEX_MAGIC "WMSIDX1\n"
+#define HIST_INDEX_SUFFIX ".idx"
+#define HIST_INDEX_ENTRY_LEN (32 + NCHANNELS * 16)
+
+struct hist_block {
+  time_t t0, t1;               /* first and last timestamp */
+  int n;                       /* samples in the block */
+  unsigned long nbits;         /* bits used in data */
+  unsigned char data[HIST_BLOCK_BYTES];
+  double min[NCHANNELS], max[NCHANNELS];  /* ignoring NO_READING */
+
+  /* Encoder state */
+  long delta;
+  uint64_t prev[NCHANNELS];
+  int lead[NCHANNELS], trail[NCHANNELS];
+};
+
+struct hist_index_entry {
+  time_t t0, t1;
+  long offset;                 /* of the block header in the history */
+  int n;
+  double min[NCHANNELS], max[NCHANNELS];
+};
+
+struct hist_reader {
+  const struct hist_block *b;
+  unsigned long pos;
+  int i;
+  struct sample s;
+  long delta;
+  int lead[NCHANNELS], trail[NCHANNELS];
+};
+
+struct hist_store {
+  struct hist_block cur;       /* block being filled */
+  FILE *file;                  /* where finished blocks go, or NULL */
+  FILE *index;                 /* and the index of them */
+};
+
+void hist_block_init(struct hist_block *b);
+int hist_block_append(struct hist_block *b, const struct sample *s);
+int hist_block_bytes(const struct hist_block *b);
+
+void hist_reader_init(struct hist_reader *r, const struct hist_block *b);
+int hist_reader_next(struct hist_reader *r, struct sample *s);
+
+int hist_file_write_header(FILE *f);
+int hist_file_check_header(FILE *f);
+int hist_block_write(FILE *f, const struct hist_block *b);
+int hist_block_read(FILE *f, struct hist_block *b);
+void hist_block_summarise(struct hist_block *b);
+
+int hist_index_write_header(FILE *f);
+int hist_index_append(FILE *f, const struct hist_block *b, long offset);
+long hist_index_count(FILE *f);
+int hist_index_read(FILE *f, long i, struct hist_index_entry *e);
+long hist_index_find(FILE *f, long count, time_t t);
+int hist_index_rebuild(FILE *hist, FILE *index);
+FILE *hist_index_open(const char *histname, const char *mode);
+
+int hist_store_open(struct hist_store *h, const char *filename);
+void hist_store_append(struct hist_store *h, const struct sample *s);
+void hist_store_flush(struct hist_store *h);
+
+#endif /* WMSENSORS_HISTORY_H */
@@ -0,0 +1,155 @@
+/*
+    hwmon.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include "hwmon.h"
+
+struct hwmon_alarm {
+  int fd;
+  int value;                   /* last value read */
+  int notifies;                /* driver has woken us up at least once */
+  char name[64];               /* eg. hwmon0/in3_alarm */
+};
+
+static struct hwmon_alarm alarms[MAX_HWMON_ALARMS];
+static int nalarms;
+
+/*****************************************************************************/
+/* Reads the attribute again from the start. This also re-arms the
+   notification. Returns the value, or -1 if it can't be read. */
+static int read_alarm(int fd)
+{
+  char buf[16];
+  int len;
+
+  if ((len = pread(fd, buf, sizeof(buf) - 1, 0)) <= 0)
+    return -1;
+  buf[len] = 0;
+  return buf[0] != '0';
+}
+
+/* Adds the *_alarm files of one directory */
+static void scan_dir(const char *dir, const char *hwmon)
+{
+  char path[512];
+  struct dirent *de;
+  DIR *d;
+  int fd, len, value;
+
+  if (!(d = opendir(dir)))
+    return;
+  while ((de = readdir(d)) && nalarms < MAX_HWMON_ALARMS) {
+    len = strlen(de->d_name);
+    if (len < 6 || strcmp(de->d_name + len - 6, "_alarm"))
+      continue;
+    snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+    if ((fd = open(path, O_RDONLY)) < 0)
+      continue;
+    if ((value = read_alarm(fd)) < 0) {
+      close(fd);
+      continue;
+    }
+    alarms[nalarms].fd = fd;
+    alarms[nalarms].value = value;
+    alarms[nalarms].notifies = 0;
+    snprintf(alarms[nalarms].name, sizeof(alarms[nalarms].name), "%s/%s",
+	     hwmon, de->d_name);
+    nalarms++;
+  }
+  closedir(d);
+}
+
+/* Opens every alarm attribute under dir, normally HWMON_DIR. Older
+   drivers keep their attributes in the device directory rather than the
+   hwmon one. Returns the number found. */
+int hwmon_alarms_open(const char *dir)
+{
+  char path[512];
+  struct dirent *de;
+  DIR *d;
+
+  if (!(d = opendir(dir)))
+    return 0;
+  while ((de = readdir(d))) {
+    if (strncmp(de->d_name, "hwmon", 5))
+      continue;
+    snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+    scan_dir(path, de->d_name);
+    snprintf(path, sizeof(path), "%s/%s/device", dir, de->d_name);
+    scan_dir(path, de->d_name);
+  }
+  closedir(d);
+  return nalarms;
+}
+
+/* Fills in pollfds for the alarm attributes. Returns how many. */
+int hwmon_alarms_pollfds(struct pollfd *pfd, int max)
+{
+  int i;
+
+  for (i = 0; i < nalarms && i < max; i++) {
+    pfd[i].fd = alarms[i].fd;
+    pfd[i].events = POLLPRI | POLLERR;
+    pfd[i].revents = 0;
+  }
+  return i;
+}
+
+/* Checks one attribute; returns 1 if its alarm has just gone on */
+static int update(struct hwmon_alarm *a, const char **which)
+{
+  int value = read_alarm(a->fd);
+  int raised = value > 0 && a->value == 0;
+
+  if (value >= 0)
+    a->value = value;
+  if (raised)
+    *which = a->name;
+  return raised;
+}
+
+/* Handles the result of a poll() on the fds from hwmon_alarms_pollfds().
+   Returns the number of alarms that went on, and the name of one of them
+   in *which. */
+int hwmon_alarms_notified(const struct pollfd *pfd, int n, const char **which)
+{
+  int i, raised = 0;
+
+  for (i = 0; i < n && i < nalarms; i++)
+    if (pfd[i].revents & (POLLPRI | POLLERR)) {
+      alarms[i].notifies = 1;
+      raised += update(&alarms[i], which);
+    }
+  return raised;
+}
+
+/* The periodic fallback, for drivers that don't notify */
+int hwmon_alarms_recheck(const char **which)
+{
+  int i, raised = 0;
+
+  for (i = 0; i < nalarms; i++)
+    if (!alarms[i].notifies)
+      raised += update(&alarms[i], which);
+  return raised;
+}
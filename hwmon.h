@@ -0,0 +1,42 @@
+/*
+    hwmon.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_HWMON_H
+#define WMSENSORS_HWMON_H
+
+#include <poll.h>
+
+/*************************************************************************/
+/* Alarm attributes of the kernel's hwmon drivers.                       */
+/*                                                                       */
+/* Drivers that call sysfs_notify() on their *_alarm files wake a poll() */
+/* for POLLPRI as soon as an alarm changes, so we don't have to wait for */
+/* the next sample to see it. Attributes that have never notified us are */
+/* re-read on every sample instead.                                      */
+/*************************************************************************/
+
+#define HWMON_DIR "/sys/class/hwmon"
+#define MAX_HWMON_ALARMS 64
+
+int hwmon_alarms_open(const char *dir);
+int hwmon_alarms_pollfds(struct pollfd *pfd, int max);
+int hwmon_alarms_notified(const struct pollfd *pfd, int n, const char **which);
+int hwmon_alarms_recheck(const char **which);
+
+#endif /* WMSENSORS_HWMON_H */
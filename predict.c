@@ -0,0 +1,92 @@
+/*
+    predict.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include "sample.h"
+#include "predict.h"
+
+void trend_reset(struct trend *tr)
+{
+  tr->level = tr->slope = 0;
+  tr->t = 0;
+  tr->n = 0;
+}
+
+/* Takes one reading into the trend. Missing readings are skipped; the
+   next one just has a longer gap. */
+void trend_update(struct trend *tr, time_t t, double v)
+{
+  double dt, last;
+
+  if (v == NO_READING)
+    return;
+  if (!tr->n) {
+    tr->level = v;
+    tr->slope = 0;
+  } else {
+    /* Readings without a time (old logs) are taken as a second apart */
+    dt = t > tr->t ? (double)(t - tr->t) : 1;
+    last = tr->level;
+    tr->level = PREDICT_ALPHA * v
+      + (1 - PREDICT_ALPHA) * (last + tr->slope * dt);
+    tr->slope = PREDICT_BETA * (tr->level - last) / dt
+      + (1 - PREDICT_BETA) * tr->slope;
+  }
+  tr->t = t;
+  tr->n++;
+}
+
+/* Where the trend says the channel will be ahead seconds after the last
+   reading */
+double trend_forecast(const struct trend *tr, double ahead)
+{
+  return tr->level + tr->slope * ahead;
+}
+
+/* Returns how many seconds from the last reading the trend will take the
+   channel below lo or above hi, or -1 if not within horizon (or if there
+   haven't been enough readings to say) */
+double trend_crossing(const struct trend *tr, double lo, double hi,
+		      double horizon)
+{
+  double when;
+
+  if (tr->n < PREDICT_WARMUP)
+    return -1;
+  if (tr->level > hi || tr->level < lo)
+    return 0;
+  if (tr->slope > 0)
+    when = (hi - tr->level) / tr->slope;
+  else if (tr->slope < 0)
+    when = (lo - tr->level) / tr->slope;
+  else
+    return -1;
+  return when <= horizon ? when : -1;
+}
+
+/* Returns the limit trend_crossing() measured against: the one the
+   smoothed level is already past, if it is, or else the one the slope
+   is heading for */
+double trend_limit(const struct trend *tr, double lo, double hi)
+{
+  if (tr->level > hi)
+    return hi;
+  if (tr->level < lo)
+    return lo;
+  return tr->slope > 0 ? hi : lo;
+}
@@ -0,0 +1,50 @@
+/*
+    predict.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_PREDICT_H
+#define WMSENSORS_PREDICT_H
+
+#include <time.h>
+
+/*************************************************************************/
+/* Where each channel is heading. Every reading updates a smoothed level */
+/* and slope (Holt's linear method, allowing for uneven gaps between     */
+/* readings) in constant time, and the straight line through them says  */
+/* how soon a limit will be crossed if things carry on as they are.     */
+/*************************************************************************/
+
+#define PREDICT_ALPHA  0.2        /* weight of a new reading in the level */
+#define PREDICT_BETA   0.05       /* and of the new slope in the slope */
+#define PREDICT_WARMUP 4          /* readings before the slope is trusted */
+
+struct trend {
+  double level;
+  double slope;                /* per second */
+  time_t t;                    /* of the last reading */
+  int n;                       /* readings so far */
+};
+
+void trend_reset(struct trend *tr);
+void trend_update(struct trend *tr, time_t t, double v);
+double trend_forecast(const struct trend *tr, double ahead);
+double trend_crossing(const struct trend *tr, double lo, double hi,
+		      double horizon);
+double trend_limit(const struct trend *tr, double lo, double hi);
+
+#endif /* WMSENSORS_PREDICT_H */
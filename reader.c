@@ -0,0 +1,180 @@
+/*
+    reader.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sensors/sensors.h"
+#include "sensors/chips.h"
+#include "reader.h"
+#include "trace.h"
+
+static const int features[NFEATURES] = {
+  SENSORS_LM78_IN0, SENSORS_LM78_IN1, SENSORS_LM78_IN2, SENSORS_LM78_IN3,
+  SENSORS_LM78_IN4, SENSORS_LM78_IN5, SENSORS_LM78_IN6, SENSORS_LM78_TEMP,
+  SENSORS_LM78_FAN1, SENSORS_LM78_FAN2, SENSORS_LM78_FAN3,
+  SENSORS_LM78_ALARMS, SENSORS_W83781D_TEMP2, SENSORS_W83781D_TEMP3
+};
+
+struct chip_health {
+  unsigned usual;              /* features it has given */
+  int failures;                /* in a row */
+  long long retry_at;          /* ms, CLOCK_MONOTONIC */
+};
+
+static const sensors_chip_name *chip_names[MAX_CHIPS];
+static struct chip_health health[MAX_CHIPS];
+static int nchips;
+
+/*****************************************************************************/
+static long long now_ms(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+static void complain(int chip, const char *what)
+{
+  fprintf(stderr,"wmsensors: %s (bus %d, address 0x%x) %s\n",
+	  chip_names[chip]->prefix, chip_names[chip]->bus,
+	  chip_names[chip]->addr, what);
+}
+
+/* Leaves a chip alone for longer after each failure in a row */
+static void chip_failed(int chip)
+{
+  struct chip_health *h = &health[chip];
+  long long backoff;
+
+  backoff = CHIP_BACKOFF_MIN * 1000LL << (h->failures < 16 ? h->failures : 16);
+  if (backoff > CHIP_BACKOFF_MAX * 1000LL)
+    backoff = CHIP_BACKOFF_MAX * 1000LL;
+  if (!h->failures++ && h->usual)
+    complain(chip, "is not responding, trying it less often");
+  h->retry_at = now_ms() + backoff;
+}
+
+static int find_chip(const sensors_chip_name *name)
+{
+  int chip;
+
+  for (chip = 0; chip < nchips; chip++)
+    if (chip_names[chip] == name)
+      return chip;
+  return -1;
+}
+
+/* Reads one chip, unless it is failing and not due another try. A chip
+   that gives nothing, or is still going at its deadline, has failed. */
+static void read_chip(int chip, struct chip_reading *r)
+{
+  struct chip_health *h = &health[chip];
+  long long start = now_ms();
+  int f;
+
+  r->got = 0;
+  if (h->failures && start < h->retry_at) {
+    r->stale = h->usual;
+    return;
+  }
+  TRACE_BEGIN(chip, chip);
+  for (f = 0; f < NFEATURES; f++) {
+    if (!sensors_get_feature(*chip_names[chip], features[f], &r->v[f]))
+      r->got |= 1 << f;
+    if (now_ms() - start > CHIP_DEADLINE_MS)
+      break;                   /* don't wait for the rest */
+  }
+  TRACE_END(chip, chip);
+
+  if (r->got && f == NFEATURES) {
+    if (h->failures && h->usual)
+      complain(chip, "is back");
+    h->failures = 0;
+  } else
+    chip_failed(chip);
+  h->usual |= r->got;
+  r->stale = h->usual & ~r->got;
+}
+
+/*****************************************************************************/
+/* Remembers the detected chips. Must be called after sensors_init().
+   Returns the number of chips. */
+int reader_init(void)
+{
+  const sensors_chip_name *name;
+  int chip_nr;
+
+  nchips = 0;
+  memset(health, 0, sizeof(health));
+  for (chip_nr = 0; nchips < MAX_CHIPS
+	 && (name = sensors_get_detected_chips(&chip_nr));)
+    chip_names[nchips++] = name;
+  return nchips;
+}
+
+/* Forgets the chips, so sensors_cleanup() can be called */
+void reader_cleanup(void)
+{
+  nchips = 0;
+}
+
+/* Reads every chip into out[], in the order libsensors detected them.
+   Chips left alone after failing come back with nothing read, and what
+   they used to give marked stale. Returns the number of chips. */
+int reader_sample(struct chip_reading *out, int max)
+{
+  int i, n = nchips < max ? nchips : max;
+
+  for (i = 0; i < n; i++)
+    read_chip(i, &out[i]);
+  return n;
+}
+
+/* Whether name has failed and not yet been read properly again. Reading
+   anything else from it would most likely just wait for its deadline. */
+int reader_chip_backed_off(const sensors_chip_name *name)
+{
+  int chip = find_chip(name);
+
+  return chip >= 0 && health[chip].failures;
+}
+
+/* Reads n features the sample doesn't cover (the limits) into *dest[],
+   giving up on the rest at the chip's deadline. Running out of time
+   counts as a failure, as it does for a sample. Returns how many were
+   read. */
+int reader_get_features(const sensors_chip_name *name, const int *feature,
+			double *const *dest, int n)
+{
+  long long start = now_ms();
+  int i, got = 0, chip = find_chip(name);
+
+  for (i = 0; i < n; i++) {
+    if (!sensors_get_feature(*name, feature[i], dest[i]))
+      got++;
+    if (now_ms() - start > CHIP_DEADLINE_MS) {
+      if (chip >= 0)
+	chip_failed(chip);
+      break;
+    }
+  }
+  return got;
+}
@@ -0,0 +1,83 @@
+/*
+    reader.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_READER_H
+#define WMSENSORS_READER_H
+
+#include "sensors/sensors.h"
+
+/*************************************************************************/
+/* Reads the detected chips, one after another in the order libsensors  */
+/* found them. libsensors 2.x is not reentrant (it keeps global state    */
+/* and reads /proc into a static buffer), so chips on different buses    */
+/* can't be read at the same time either; what keeps a slow chip from    */
+/* holding an update up is its deadline.                                 */
+/*                                                                       */
+/* A chip that gives nothing, or takes longer than its deadline, is      */
+/* left alone for a while: 2 seconds after the first failure, doubling   */
+/* with each one after that up to 5 minutes. Until it is tried again     */
+/* (and works) what it used to give is reported as stale. Its limits     */
+/* aren't read in the meantime either.                                   */
+/*************************************************************************/
+
+#define MAX_CHIPS 32
+
+#define MAX_CHIPS 32
+#define MAX_BUSES 16
+
+/* How long one chip may take before the rest of it is skipped and it
+   counts as failed, in milliseconds */
+#define CHIP_DEADLINE_MS 250
+
+/* How long a failed chip is left before it is tried again, in seconds */
+#define CHIP_BACKOFF_MIN 2
+#define CHIP_BACKOFF_MAX 300
+
+/* The features read from each chip */
+#define F_IN0    0
+#define F_IN1    1
+#define F_IN2    2
+#define F_IN3    3
+#define F_IN4    4
+#define F_IN5    5
+#define F_IN6    6
+#define F_TEMP   7
+#define F_FAN1   8
+#define F_FAN2   9
+#define F_FAN3   10
+#define F_ALARMS 11
+#define F_TEMP2  12
+#define F_TEMP3  13
+#define NFEATURES 14
+
+struct chip_reading {
+  double v[NFEATURES];
+  unsigned got;                /* bit n set if v[n] was read */
+  unsigned stale;              /* and if it has been read before, but wasn't
+				  this time */
+};
+
+int reader_init(void);
+void reader_cleanup(void);
+int reader_sample(struct chip_reading *out, int max);
+int reader_chip_backed_off(const sensors_chip_name *name);
+int reader_get_features(const sensors_chip_name *name, const int *feature,
+			double *const *dest, int n);
+
+#endif /* WMSENSORS_READER_H */
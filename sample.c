@@ -0,0 +1,117 @@
+/*
+    sample.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sample.h"
+
+const char *channel_names[NCHANNELS] = {
+  "temp1", "temp2", "temp3", "in0", "in1", "in2", "in3", "in4", "in5",
+  "in6", "fan1", "fan2", "fan3"
+};
+
+/*****************************************************************************/
+/* Returns the index of a channel given its name, or -1 */
+int channel_lookup(const char *name)
+{
+  int i;
+
+  for (i = 0; i < NCHANNELS; i++)
+    if (!strcmp(name, channel_names[i]))
+      return i;
+  return -1;
+}
+
+/*****************************************************************************/
+/* The limits used when the chips don't tell us theirs */
+void default_limits(struct limits *l)
+{
+  int i;
+
+  for (i = 0; i < NCHANNELS; i++) {
+    l->lo[i] = -HUGE_VAL;
+    l->hi[i] = HUGE_VAL;
+  }
+  l->temp_base = 20;
+  l->hi[CH_TEMP1] = 60;
+  l->hi[CH_TEMP2] = 60;
+  l->hi[CH_TEMP3] = 60;
+  l->lo[CH_IN0] = 1.8;
+  l->hi[CH_IN0] = 2.2;
+  l->lo[CH_IN1] = 1.8;
+  l->hi[CH_IN1] = 2.2;
+  l->lo[CH_IN2] = 3.0;
+  l->hi[CH_IN2] = 3.6;
+  l->lo[CH_IN3] = 4.5;
+  l->hi[CH_IN3] = 5.5;
+  l->lo[CH_IN4] = 10.80;
+  l->hi[CH_IN4] = 13.20;
+  l->lo[CH_IN5] = -13.20;
+  l->hi[CH_IN5] = -10.80;
+  l->lo[CH_IN6] = -5.5;
+  l->hi[CH_IN6] = -4.5;
+}
+
+/*****************************************************************************/
+/* Parses one line of a -r log file into s. Returns 2 if the line held a
+   timestamped sample, 1 for a sample from an old log without timestamps
+   (s->t is left alone) and 0 for the header, comments and anything else
+   we don't understand. Lines marked "# Error " or "# Stale " still
+   carry a full sample. */
+int parse_log_line(const char *line, struct sample *s)
+{
+  double f[NCHANNELS + 1];
+  char *end;
+  int i, n;
+
+  if (!strncmp(line, "# Error ", 8) || !strncmp(line, "# Stale ", 8))
+    line += 8;
+  for (n = 0; n < NCHANNELS + 1; n++) {
+    f[n] = strtod(line, &end);
+    if (end == line)
+      break;
+    line = end;
+  }
+  if (n < NCHANNELS)
+    return 0;
+  if (n == NCHANNELS) {
+    for (i = 0; i < NCHANNELS; i++)
+      s->v[i] = f[i];
+    return 1;
+  }
+  s->t = (time_t)f[0];
+  for (i = 0; i < NCHANNELS; i++)
+    s->v[i] = f[i + 1];
+  return 2;
+}
+
+/*****************************************************************************/
+/* Formats s the way the -r log file wants it. Returns the length written,
+   as snprintf would. */
+int format_log_line(char *buf, int len, const struct sample *s)
+{
+  const double *v = s->v;
+
+  return snprintf(buf, len, LOG_FORMAT, (long)s->t,
+		  v[CH_TEMP1], v[CH_TEMP2], v[CH_TEMP3], v[CH_IN0], v[CH_IN1],
+		  v[CH_IN2], v[CH_IN3], v[CH_IN4], v[CH_IN5], v[CH_IN6],
+		  v[CH_FAN1], v[CH_FAN2], v[CH_FAN3]);
+}
@@ -0,0 +1,74 @@
+/*
+    sample.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_SAMPLE_H
+#define WMSENSORS_SAMPLE_H
+
+#include <time.h>
+
+/*************************************************************************/
+/* One reading of every channel wmsensors knows about. The channels are  */
+/* in the same order as the columns of the -r log file.                  */
+/*************************************************************************/
+
+#define NCHANNELS 13
+
+#define CH_TEMP1 0
+#define CH_TEMP2 1
+#define CH_TEMP3 2
+#define CH_IN0   3
+#define CH_IN1   4
+#define CH_IN2   5
+#define CH_IN3   6
+#define CH_IN4   7
+#define CH_IN5   8
+#define CH_IN6   9
+#define CH_FAN1  10
+#define CH_FAN2  11
+#define CH_FAN3  12
+
+/* Value left in a channel when the sensor didn't return a reading */
+#define NO_READING -279
+
+/* The log file's header and line format. The first column is the time
+   of the reading in seconds since the epoch; logs written before it was
+   added have only the 13 readings. */
+#define LOG_HEADER "time      temp1 temp2 temp3 in0  in1  in2  in3  in4   in5    in6   fan1    fan2    fan3\n"
+#define LOG_FORMAT "%ld %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f\n"
+
+struct sample {
+  time_t t;
+  double v[NCHANNELS];
+};
+
+/* The limits of each channel, as set in sensors.conf. Channels without a
+   limit have -HUGE_VAL or HUGE_VAL. The graphs are scaled to these. */
+struct limits {
+  double lo[NCHANNELS], hi[NCHANNELS];
+  double temp_base;            /* bottom of the temperature graph */
+};
+
+extern const char *channel_names[NCHANNELS];
+
+int channel_lookup(const char *name);
+void default_limits(struct limits *l);
+int parse_log_line(const char *line, struct sample *s);
+int format_log_line(char *buf, int len, const struct sample *s);
+
+#endif /* WMSENSORS_SAMPLE_H */
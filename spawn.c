@@ -0,0 +1,117 @@
+/*
+    spawn.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#define _GNU_SOURCE          /* for pipe2 */
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "spawn.h"
+
+/* What makes a command need the shell */
+#define SHELL_CHARS "|&;<>()$`\\\"'*?[]#~=%{}\n"
+
+/*****************************************************************************/
+/* Children are never waited for: the kernel reaps them itself */
+void command_init(void)
+{
+  struct sigaction sa;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = SIG_IGN;
+  sa.sa_flags = SA_NOCLDWAIT;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGCHLD, &sa, NULL);
+}
+
+/* Sets c to run line, which may be NULL or empty for nothing. Returns 0,
+   or -1 (leaving no command) if line is too long. */
+int command_parse(struct command *c, const char *line)
+{
+  char *p;
+  int n = 0;
+
+  c->argv[0] = NULL;
+  if (c->running)
+    close(c->done_fd);
+  c->running = 0;
+  if (!line || !*line)
+    return 0;
+  if (strlen(line) >= sizeof(c->buf))
+    return -1;
+  strcpy(c->buf, line);
+  if (strpbrk(c->buf, SHELL_CHARS)) {
+    c->argv[n++] = "/bin/sh";
+    c->argv[n++] = "-c";
+    c->argv[n++] = c->buf;
+  } else
+    for (p = strtok(c->buf, " \t"); p; p = strtok(NULL, " \t")) {
+      if (n == COMMAND_ARGS) {
+	c->argv[0] = NULL;
+	return -1;
+      }
+      c->argv[n++] = p;
+    }
+  c->argv[n] = NULL;
+  return 0;
+}
+
+/* Starts c, unless it is still running from last time. Returns 1 if it
+   was started.
+
+   The command is given the write end of a pipe, so the read end sees
+   EOF once it (and anything it started that kept the descriptor) has
+   gone. Its pid would do as well only until the pid is reused, and with
+   nobody waiting for children that can happen at any time. */
+int command_run(struct command *c)
+{
+  char byte;
+  int fds[2];
+  pid_t pid;
+
+  if (!c->argv[0])
+    return 0;
+  if (c->running) {
+    if (read(c->done_fd, &byte, 1) < 0)
+      return 0;                /* EAGAIN: still going */
+    close(c->done_fd);
+    c->running = 0;
+  }
+  if (pipe2(fds, O_CLOEXEC | O_NONBLOCK))
+    return 0;
+  if ((pid = fork()) < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+  }
+  if (!pid) {
+    /* Ignored signals stay ignored across exec; the command shouldn't
+       inherit what wmsensors wanted for itself */
+    signal(SIGCHLD, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+    fcntl(fds[1], F_SETFD, 0);  /* held through the exec */
+    execvp(c->argv[0], c->argv);
+    _exit(127);
+  }
+  close(fds[1]);
+  c->done_fd = fds[0];
+  c->running = 1;
+  return 1;
+}
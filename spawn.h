@@ -0,0 +1,46 @@
+/*
+    spawn.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_SPAWN_H
+#define WMSENSORS_SPAWN_H
+
+/*************************************************************************/
+/* Commands run on alarms and mouse clicks. They are split into words    */
+/* once, when they are given, and started with fork() and exec without   */
+/* waiting for them, so running one costs the update neither a shell nor */
+/* any memory. A command with anything a shell would have to deal with   */
+/* (quotes, pipes, &, $ and so on) is run by /bin/sh -c as before.       */
+/*************************************************************************/
+
+#define COMMAND_LEN  1024
+#define COMMAND_ARGS 32
+
+struct command {
+  char *argv[COMMAND_ARGS + 1];  /* argv[0] NULL for no command */
+  char buf[COMMAND_LEN];
+  int running;                   /* the last run may still be going... */
+  int done_fd;                   /* ...until this pipe, which it holds
+				    the other end of, reads EOF */
+};
+
+void command_init(void);
+int command_parse(struct command *c, const char *line);
+int command_run(struct command *c);
+
+#endif /* WMSENSORS_SPAWN_H */
@@ -0,0 +1,199 @@
+/*
+    stream.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include "stream.h"
+
+static const char *target_name;  /* NULL for stdout */
+static int fd = -1;
+static int active;
+static int dontwait;           /* stdout is a socket; send() without blocking */
+static int policy;
+static unsigned long dropped;
+
+/* The queue. Only the line at head can be partly written. */
+static char lines[STREAM_QUEUE_LEN][STREAM_LINE_MAX];
+static int lens[STREAM_QUEUE_LEN];
+static int head, count, head_off;
+
+/*****************************************************************************/
+/* Opens the target without blocking. A FIFO nobody is reading yet gives
+   ENXIO; we try again on the next sample. */
+static int open_target(void)
+{
+  if ((fd = open(target_name, O_WRONLY | O_NONBLOCK | O_CREAT | O_APPEND,
+		 0644)) < 0 && errno != ENXIO)
+    return -1;
+  return 0;
+}
+
+/* Starts streaming to target ("-" for stdout) with the given overflow
+   policy */
+int stream_open(const char *target, int pol)
+{
+  struct stat st;
+
+  policy = pol;
+  active = 1;
+  signal(SIGPIPE, SIG_IGN);
+  if (!strcmp(target, "-")) {
+    target_name = NULL;
+    /* O_NONBLOCK belongs to the open file, which stdout shares with the
+       terminal, stderr and -r -, so it is never set there. A regular
+       file doesn't block anyway, a socket is sent to with MSG_DONTWAIT,
+       and a pipe or terminal is opened again as a file of our own. */
+    if (fstat(1, &st) < 0)
+      return -1;
+    fd = 1;
+    if (S_ISREG(st.st_mode))
+      return 0;
+    if (S_ISSOCK(st.st_mode)) {
+      dontwait = 1;
+      return 0;
+    }
+    return (fd = open("/proc/self/fd/1", O_WRONLY | O_NONBLOCK)) < 0 ? -1 : 0;
+  }
+  target_name = target;
+  return open_target();
+}
+
+/* Returns the policy for "oldest", "newest" or "coalesce", or -1 */
+int stream_policy(const char *name)
+{
+  if (!strcmp(name, "oldest"))
+    return STREAM_DROP_OLDEST;
+  if (!strcmp(name, "newest"))
+    return STREAM_DROP_NEWEST;
+  if (!strcmp(name, "coalesce"))
+    return STREAM_COALESCE;
+  return -1;
+}
+
+unsigned long stream_dropped(void)
+{
+  return dropped;
+}
+
+/*****************************************************************************/
+static void enqueue(const char *line, int len)
+{
+  int slot;
+
+  if (count == STREAM_QUEUE_LEN) {
+    dropped++;
+    if (policy == STREAM_DROP_NEWEST)
+      return;
+    if (policy == STREAM_DROP_OLDEST && head_off == 0) {
+      head = (head + 1) % STREAM_QUEUE_LEN;
+      count--;
+    } else {
+      /* Coalesce, or the oldest line is already half way out */
+      slot = (head + count - 1) % STREAM_QUEUE_LEN;
+      memcpy(lines[slot], line, len);
+      lens[slot] = len;
+      return;
+    }
+  }
+  slot = (head + count) % STREAM_QUEUE_LEN;
+  memcpy(lines[slot], line, len);
+  lens[slot] = len;
+  count++;
+}
+
+/* Writes as much of the queue as the descriptor will take right now */
+void stream_flush(void)
+{
+  int n;
+
+  if (!active)
+    return;
+  if (fd < 0 && (!target_name || open_target() || fd < 0))
+    return;
+  while (count) {
+    if (dontwait)
+      n = send(fd, lines[head] + head_off, lens[head] - head_off, MSG_DONTWAIT);
+    else
+      n = write(fd, lines[head] + head_off, lens[head] - head_off);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EINTR)
+	return;
+      /* The reader has gone away. Whatever is queued is lost; a named
+	 target is reopened on the next sample. */
+      dropped += count;
+      count = head_off = 0;
+      if (fd != 1)
+	close(fd);
+      if (!target_name)
+	active = 0;
+      fd = -1;
+      return;
+    }
+    head_off += n;
+    if (head_off == lens[head]) {
+      head = (head + 1) % STREAM_QUEUE_LEN;
+      count--;
+      head_off = 0;
+    }
+  }
+}
+
+/* Queues one JSON object for the sample and tries to send it */
+void stream_push(const struct sample *s, int alarm)
+{
+  char line[STREAM_LINE_MAX];
+  int len, c;
+
+  if (!active)
+    return;
+  len = snprintf(line, sizeof(line), "{\"time\":%ld", (long)s->t);
+  for (c = 0; c < NCHANNELS; c++)
+    if (s->v[c] == NO_READING)
+      len += snprintf(line + len, sizeof(line) - len, ",\"%s\":null",
+		      channel_names[c]);
+    else
+      len += snprintf(line + len, sizeof(line) - len, ",\"%s\":%.2f",
+		      channel_names[c], s->v[c]);
+  len += snprintf(line + len, sizeof(line) - len,
+		  ",\"alarm\":%s,\"dropped\":%lu}\n",
+		  alarm ? "true" : "false", dropped);
+  if (len >= (int)sizeof(line))
+    return;
+  enqueue(line, len);
+  stream_flush();
+}
+
+/* Fills in pfd if there is something waiting to be written. Returns 1 if
+   so, else 0. */
+int stream_pollfd(struct pollfd *pfd)
+{
+  if (!active || fd < 0 || !count)
+    return 0;
+  pfd->fd = fd;
+  pfd->events = POLLOUT;
+  pfd->revents = 0;
+  return 1;
+}
@@ -0,0 +1,47 @@
+/*
+    stream.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_STREAM_H
+#define WMSENSORS_STREAM_H
+
+#include <poll.h>
+#include "sample.h"
+
+/*************************************************************************/
+/* JSON Lines output for other programs to read. The descriptor is non- */
+/* blocking and lines wait in a small queue until it can take them, so a */
+/* reader that stops reading can never hold up sampling or the alarms.   */
+/* When the queue is full the overflow policy decides what is lost.      */
+/*************************************************************************/
+
+#define STREAM_QUEUE_LEN 64
+#define STREAM_LINE_MAX  512
+
+#define STREAM_DROP_OLDEST 0     /* throw away the oldest queued line */
+#define STREAM_DROP_NEWEST 1     /* throw away the new line */
+#define STREAM_COALESCE    2     /* replace the newest queued line */
+
+int stream_open(const char *target, int policy);
+int stream_policy(const char *name);
+void stream_push(const struct sample *s, int alarm);
+void stream_flush(void);
+int stream_pollfd(struct pollfd *pfd);
+unsigned long stream_dropped(void);
+
+#endif /* WMSENSORS_STREAM_H */
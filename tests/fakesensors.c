@@ -0,0 +1,96 @@
+/*
+    tests/fakesensors.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "sensors/sensors.h"
+#include "sensors/error.h"
+#include "fakesensors.h"
+
+int fake_bus[FAKE_CHIPS] = { 0, 0, 0, 0 };
+int fake_dead_chip = -1;
+int fake_dead_ms;
+int fake_pread;
+int fake_inits;
+int fake_reads;
+
+static sensors_chip_name names[FAKE_CHIPS] = {
+  { "lm78", 0, 0x2d, "" }, { "lm75", 0, 0x48, "" },
+  { "lm75", 0, 0x49, "" }, { "w83781d", 0, 0x290, "" }
+};
+static int nchips;              /* 0 until a configuration is loaded */
+static int zero = -1;
+
+int sensors_init(FILE *input)
+{
+  char line[80];
+
+  fake_inits++;
+  nchips = 0;
+  if (!fgets(line, sizeof(line), input)
+      || sscanf(line, "chips %d", &nchips) != 1
+      || nchips < 1 || nchips > FAKE_CHIPS) {
+    nchips = 0;
+    return SENSORS_ERR_PARSE;
+  }
+  return 0;
+}
+
+void sensors_cleanup(void)
+{
+  nchips = 0;
+}
+
+const char *sensors_strerror(int errnum)
+{
+  return errnum == SENSORS_ERR_PARSE ? "Parse error" : "Unknown error";
+}
+
+const sensors_chip_name *sensors_get_detected_chips(int *nr)
+{
+  if (*nr >= nchips)
+    return NULL;
+  names[*nr].bus = fake_bus[*nr];
+  return &names[(*nr)++];
+}
+
+int sensors_get_feature(sensors_chip_name name, int feature, double *result)
+{
+  char c;
+  int chip;
+
+  for (chip = 0; chip < nchips && names[chip].addr != name.addr; chip++)
+    ;
+  if (chip == nchips)
+    return SENSORS_ERR_PARSE;
+  if (chip == fake_dead_chip) {
+    fake_reads++;
+    usleep(fake_dead_ms * 1000);
+    return SENSORS_ERR_PROC;
+  }
+  if (fake_pread) {
+    if (zero < 0)
+      zero = open("/dev/zero", O_RDONLY);
+    pread(zero, &c, 1, 0);
+  }
+  *result = feature % 16 + 1;
+  return 0;
+}
@@ -0,0 +1,40 @@
+/*
+    tests/fakesensors.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_FAKESENSORS_H
+#define WMSENSORS_FAKESENSORS_H
+
+/*************************************************************************/
+/* A stand-in for libsensors, for the tests run by make check. It has up */
+/* to FAKE_CHIPS chips, on bus 0 unless fake_bus[] says otherwise, and   */
+/* every feature reads as a small number. The configuration it is given  */
+/* is a line "chips N", saying how many chips there are; anything else   */
+/* is a parse error. Until sensors_init() has worked there are no chips. */
+/*************************************************************************/
+
+#define FAKE_CHIPS 4
+
+extern int fake_bus[FAKE_CHIPS];  /* bus of each chip, -1 for ISA */
+extern int fake_dead_chip;        /* this chip fails, or -1 for none... */
+extern int fake_dead_ms;          /* ...after this many ms per feature */
+extern int fake_pread;            /* make one system call per feature */
+extern int fake_inits;            /* number of sensors_init() calls */
+extern int fake_reads;            /* features read from fake_dead_chip */
+
+#endif /* WMSENSORS_FAKESENSORS_H */
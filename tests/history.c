@@ -0,0 +1,112 @@
+/*
+    tests/history.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Round trips samples through a block, and checks that a damaged block,
+   one claiming more samples than its data holds or holding garbage, is
+   reported as damaged without reading past its data */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../history.h"
+
+static int failed;
+
+static void check(int ok, const char *what)
+{
+  if (!ok) {
+    fprintf(stderr, "history: %s\n", what);
+    failed = 1;
+  }
+}
+
+/* Decodes b, returning the last result of hist_reader_next() */
+static int decode(const struct hist_block *b, int *n)
+{
+  struct hist_reader r;
+  struct sample s;
+  int res;
+
+  *n = 0;
+  hist_reader_init(&r, b);
+  while ((res = hist_reader_next(&r, &s)) > 0)
+    (*n)++;
+  check(r.pos <= b->nbits + 1, "the reader went past the end of the data");
+  return res;
+}
+
+int main(void)
+{
+  static struct hist_block b, d;
+  struct hist_reader r;
+  struct sample s, t;
+  FILE *f;
+  int i, c, n, res, same = 1;
+
+  /* Round trip */
+  hist_block_init(&b);
+  for (i = 0; i < 200; i++) {
+    s.t = 1000000000 + i * (i % 7 ? 2 : 5);
+    for (c = 0; c < NCHANNELS; c++)
+      s.v[c] = c == 3 && i % 11 == 0 ? NO_READING : 40 + c + (i % 13) * 0.25;
+    hist_block_append(&b, &s);
+  }
+  hist_reader_init(&r, &b);
+  for (i = 0; (res = hist_reader_next(&r, &t)) > 0; i++) {
+    s.t = 1000000000 + i * (i % 7 ? 2 : 5);
+    same &= t.t == s.t;
+    for (c = 0; c < NCHANNELS; c++)
+      same &= t.v[c] == (c == 3 && i % 11 == 0 ? NO_READING
+			 : 40 + c + (i % 13) * 0.25);
+  }
+  check(res == 0 && i == 200 && same, "samples didn't come back as they went in");
+
+  /* More samples than bits */
+  d = b;
+  d.n = HIST_BLOCK_SAMPLES;
+  d.nbits = 64 * NCHANNELS + 10;
+  res = decode(&d, &n);
+  check(res < 0 && n == 1, "a short block wasn't reported as damaged");
+
+  /* Garbage, all of it */
+  srand(1);
+  for (i = 0; i < 100; i++) {
+    d.n = HIST_BLOCK_SAMPLES;
+    d.nbits = rand() % (HIST_BLOCK_BYTES * 8);
+    for (c = 0; c < HIST_BLOCK_BYTES; c++)
+      d.data[c] = rand();
+    decode(&d, &n);
+  }
+
+  /* The same through a file, as the tools read it */
+  f = tmpfile();
+  hist_file_write_header(f);
+  d = b;
+  d.n = HIST_BLOCK_SAMPLES;
+  hist_block_write(f, &d);
+  rewind(f);
+  hist_file_check_header(f);
+  check(hist_block_read(f, &d) == 0, "couldn't read the block back");
+  res = decode(&d, &n);
+  check(res < 0 && n == 200, "a block claiming too many samples wasn't reported");
+  fclose(f);
+
+  printf("history: %s\n", failed ? "failed" : "ok");
+  return failed;
+}
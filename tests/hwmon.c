@@ -0,0 +1,163 @@
+/*
+    tests/hwmon.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Measures how long an alarm takes to be seen when the driver notifies
+   us, against the periodic fallback. A fake hwmon directory holds two
+   alarm files; in0_alarm "notifies" and temp1_alarm doesn't. Regular
+   files can't raise POLLPRI, so the notification is handed over the way
+   poll() would report it, right after the file changes. Both alarms go
+   on at different points of an update; the notified one has to be seen
+   at once and only once, the other at the next update and no sooner. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../hwmon.h"
+
+#define TICK_MS 100
+#define EVENTS 9
+
+static char dir[] = "/tmp/wmshwmonXXXXXX";
+static int failed;
+
+static void check(int ok, const char *what)
+{
+  if (!ok) {
+    fprintf(stderr, "hwmon: %s\n", what);
+    failed = 1;
+  }
+}
+
+static double now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void sleep_until(double t)
+{
+  double left = t - now_ms();
+
+  if (left > 0)
+    usleep(left * 1000);
+}
+
+static void set_alarm(const char *name, int on)
+{
+  char path[512];
+  FILE *f;
+
+  snprintf(path, sizeof(path), "%s/hwmon0/%s", dir, name);
+  if (!(f = fopen(path, "w"))) {
+    perror(path);
+    exit(1);
+  }
+  fprintf(f, "%d\n", on);
+  fclose(f);
+}
+
+/* The index of name among the pollfds, by inode */
+static int find(const struct pollfd *pfd, int n, const char *name)
+{
+  char path[512];
+  struct stat a, b;
+  int i;
+
+  snprintf(path, sizeof(path), "%s/hwmon0/%s", dir, name);
+  if (stat(path, &a))
+    return -1;
+  for (i = 0; i < n; i++)
+    if (!fstat(pfd[i].fd, &b) && a.st_ino == b.st_ino)
+      return i;
+  return -1;
+}
+
+int main(void)
+{
+  struct pollfd pfd[MAX_HWMON_ALARMS];
+  const char *which;
+  char path[512];
+  double tick, raised, notified_ms = 0, fallback_ms = 0;
+  int n, in0, k, got;
+
+  if (!mkdtemp(dir)) {
+    perror(dir);
+    return 1;
+  }
+  snprintf(path, sizeof(path), "%s/hwmon0", dir);
+  mkdir(path, 0755);
+  set_alarm("in0_alarm", 0);
+  set_alarm("temp1_alarm", 0);
+  check(hwmon_alarms_open(dir) == 2, "didn't find both alarm files");
+  n = hwmon_alarms_pollfds(pfd, MAX_HWMON_ALARMS);
+  in0 = find(pfd, n, "in0_alarm");
+  check(in0 >= 0, "in0_alarm isn't among the pollfds");
+  if (failed)
+    return 1;
+
+  for (k = 0; k < EVENTS; k++) {
+    tick = now_ms();
+    sleep_until(tick + TICK_MS * (k + 1) / (EVENTS + 1));
+    set_alarm("in0_alarm", 1);
+    set_alarm("temp1_alarm", 1);
+    raised = now_ms();
+
+    /* The driver's notification */
+    hwmon_alarms_pollfds(pfd, n);
+    pfd[in0].revents = POLLPRI;
+    which = 0;
+    got = hwmon_alarms_notified(pfd, n, &which);
+    notified_ms += now_ms() - raised;
+    check(got == 1 && which && !strcmp(which, "hwmon0/in0_alarm"),
+	  "the notified alarm wasn't seen at once");
+
+    /* The next update */
+    sleep_until(tick + TICK_MS);
+    which = 0;
+    got = hwmon_alarms_recheck(&which);
+    fallback_ms += now_ms() - raised;
+    check(got == 1 && which && !strcmp(which, "hwmon0/temp1_alarm"),
+	  "the next update didn't see just the alarm that doesn't notify");
+
+    /* Both go off again, and stay quiet */
+    set_alarm("in0_alarm", 0);
+    set_alarm("temp1_alarm", 0);
+    hwmon_alarms_pollfds(pfd, n);
+    pfd[in0].revents = POLLPRI;
+    check(!hwmon_alarms_notified(pfd, n, &which)
+	  && !hwmon_alarms_recheck(&which), "an alarm going off was raised");
+  }
+  notified_ms /= EVENTS;
+  fallback_ms /= EVENTS;
+  printf("hwmon: alarm seen after %.3f ms notified, %.1f ms by the "
+	 "%d ms update\n", notified_ms, fallback_ms, TICK_MS);
+  check(notified_ms < fallback_ms, "notification was no quicker");
+
+  snprintf(path, sizeof(path), "rm -rf %s", dir);
+  system(path);
+  if (failed)
+    return 1;
+  printf("hwmon: pass\n");
+  return 0;
+}
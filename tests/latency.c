@@ -0,0 +1,186 @@
+/*
+    tests/latency.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Kills one chip, so that each feature read from it takes DEAD_MS and
+   fails, and checks how the reader treats it: no try reads more of it
+   than its deadline allows, the tries are at least as far apart as the
+   backoff says, its readings are reported stale rather than lost, and
+   the other chips are read every time. Then brings the chip back and
+   checks that it is read again, and kills it once more to check that
+   its limits are read to the same deadline and then left alone.
+
+   Everything checked is counted in reads of the fake chip, or is a
+   lower bound on time, so a loaded machine can only make it easier to
+   pass. The update times are printed, not checked. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "../reader.h"
+#include "fakesensors.h"
+
+#define DEAD_CHIP 1
+#define DEAD_MS   100
+#define SAMPLES   150         /* with the chip dead, 20 ms apart */
+#define MAX_TRIES 8
+#define MAX_READS (CHIP_DEADLINE_MS / DEAD_MS + 1)  /* in one try */
+
+static double now_ms(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static int by_value(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int run(void)
+{
+  struct chip_reading r[MAX_CHIPS];
+  const sensors_chip_name *name;
+  double lat[SAMPLES], tried[MAX_TRIES], t, backoff;
+  double limit[17], *dest[17];
+  int feature[17];
+  int i, k, reads, dead_reads, chip_nr, ntries = 0, stale = 0, others = 0;
+  int back = 0;
+  int failed = 0;
+
+  fake_dead_chip = -1;
+  reader_init();
+  for (i = 0; i < 5; i++)
+    reader_sample(r, MAX_CHIPS);     /* so the chip has been seen working */
+
+  fake_dead_chip = DEAD_CHIP;
+  fake_dead_ms = DEAD_MS;
+  fake_reads = 0;
+  for (i = 0; i < SAMPLES; i++) {
+    reads = fake_reads;
+    t = now_ms();
+    reader_sample(r, MAX_CHIPS);
+    lat[i] = now_ms() - t;
+    if ((reads = fake_reads - reads)) {
+      if (ntries < MAX_TRIES)
+	tried[ntries] = t;
+      ntries++;
+      if (reads > MAX_READS) {
+	fprintf(stderr, "latency: %d reads of the dead chip in one update\n",
+		reads);
+	failed = 1;
+      }
+    }
+    if (r[DEAD_CHIP].stale)
+      stale++;
+    for (k = 0; k < FAKE_CHIPS; k++)
+      if (k != DEAD_CHIP && r[k].stale)
+	others++;
+    usleep(20000);
+  }
+
+  dead_reads = fake_reads;
+
+  /* Each try waits at least twice as long as the one before */
+  backoff = CHIP_BACKOFF_MIN * 1000.0;
+  for (i = 1; i < ntries && i < MAX_TRIES; i++, backoff *= 2)
+    if (tried[i] - tried[i - 1] < backoff) {
+      fprintf(stderr, "latency: dead chip tried again after %.0f ms,"
+	      " not %.0f\n", tried[i] - tried[i - 1], backoff);
+      failed = 1;
+    }
+
+  /* It's tried again within a few seconds of coming back */
+  fake_dead_chip = -1;
+  for (i = 0; i < 100 && !back; i++) {
+    reader_sample(r, MAX_CHIPS);
+    back = r[DEAD_CHIP].got && !r[DEAD_CHIP].stale;
+    usleep(100000);
+  }
+
+  /* Its limits are read to the same deadline, and not at all once it
+     has failed */
+  chip_nr = DEAD_CHIP;
+  name = sensors_get_detected_chips(&chip_nr);
+  for (i = 0; i < 17; i++) {
+    feature[i] = i;
+    dest[i] = &limit[i];
+  }
+  if (reader_chip_backed_off(name)) {
+    fprintf(stderr, "latency: the chip's limits are still skipped\n");
+    failed = 1;
+  }
+  fake_dead_chip = DEAD_CHIP;
+  reads = fake_reads;
+  reader_get_features(name, feature, dest, 17);
+  if ((reads = fake_reads - reads) > MAX_READS) {
+    fprintf(stderr, "latency: %d reads of the dead chip's limits\n", reads);
+    failed = 1;
+  }
+  if (!reader_chip_backed_off(name)) {
+    fprintf(stderr, "latency: the dead chip's limits would be read again\n");
+    failed = 1;
+  }
+  reader_cleanup();
+
+  qsort(lat, SAMPLES, sizeof(double), by_value);
+  printf("latency: p50 %.1f ms, p90 %.1f ms, max %.1f ms;"
+	 " %d reads of the dead chip in %d tries, %d/%d stale, %s\n",
+	 lat[SAMPLES / 2], lat[SAMPLES * 9 / 10], lat[SAMPLES - 1],
+	 dead_reads, ntries, stale, SAMPLES, back ? "back" : "never came back");
+  if (!ntries) {
+    fprintf(stderr, "latency: the dead chip was never tried\n");
+    failed = 1;
+  }
+  if (stale != SAMPLES) {
+    fprintf(stderr, "latency: the dead chip's readings weren't all stale\n");
+    failed = 1;
+  }
+  if (others) {
+    fprintf(stderr, "latency: %d readings of working chips stale\n", others);
+    failed = 1;
+  }
+  if (!back) {
+    fprintf(stderr, "latency: the chip wasn't read again once it came back\n");
+    failed = 1;
+  }
+  return failed;
+}
+
+int main(void)
+{
+  FILE *config = tmpfile();
+  int failed;
+
+  if (!config || fputs("chips 4\n", config) == EOF) {
+    perror("latency");
+    return 1;
+  }
+  rewind(config);
+  if (sensors_init(config)) {
+    fprintf(stderr, "latency: fake libsensors didn't load\n");
+    return 1;
+  }
+  failed = run();
+  return failed;
+}
@@ -0,0 +1,108 @@
+/*
+    tests/predict.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Replays made-up readings through the trend the way InsertLm() does: a
+   temperature climbing steadily towards its limit has to raise the alarm
+   before it gets there, one wandering about well inside its limits must
+   never raise it, and a reading has to cost next to nothing. */
+
+#include <stdio.h>
+#include <time.h>
+#include "../sample.h"
+#include "../predict.h"
+
+#define PERIOD   4             /* seconds between readings */
+#define HORIZON  60            /* as given with -H */
+#define LO       20
+#define HI       60
+#define NOISY    100000        /* readings of flat noise */
+#define TIMED    1000000       /* readings timed */
+#define MAX_NS   1000          /* CPU time a reading may take, generously */
+
+static unsigned long seed = 1;
+
+/* -1 .. 1, the same every run */
+static double noise(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 16) & 0x7fff) / 16383.5 - 1;
+}
+
+/* Whether the alarm goes off on this reading */
+static int alarm(struct trend *tr, time_t t, double v)
+{
+  trend_update(tr, t, v);
+  return v >= LO && v <= HI && trend_crossing(tr, LO, HI, HORIZON) >= 0;
+}
+
+static double cpu_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+  struct trend tr;
+  time_t t;
+  double v, warned = -1, crossed = -1, start, ns;
+  long i, false_alarms = 0, raised = 0;
+  int failed = 0;
+
+  /* 40 degrees, climbing 0.1 a second with a little noise on top */
+  trend_reset(&tr);
+  for (t = 0; crossed < 0; t += PERIOD) {
+    v = 40 + 0.1 * t + 0.2 * noise();
+    if (v > HI)
+      crossed = t;
+    else if (alarm(&tr, t, v) && warned < 0)
+      warned = t;
+  }
+  printf("predict: ramp crosses %d at %.0f s, alarm at %.0f s\n", HI,
+	 crossed, warned);
+  if (warned < 0) {
+    fprintf(stderr, "predict: no alarm before the ramp crossed its limit\n");
+    failed = 1;
+  }
+
+  /* 40 degrees give or take 3, going nowhere */
+  trend_reset(&tr);
+  for (i = 0, t = 0; i < NOISY; i++, t += PERIOD)
+    false_alarms += alarm(&tr, t, 40 + 3 * noise());
+  printf("predict: %d false alarms in %d noisy readings\n", (int)false_alarms,
+	 NOISY);
+  if (false_alarms) {
+    fprintf(stderr, "predict: flat noise raised the alarm\n");
+    failed = 1;
+  }
+
+  trend_reset(&tr);
+  start = cpu_ns();
+  for (i = 0, t = 0; i < TIMED; i++, t += PERIOD)
+    raised += alarm(&tr, t, 40 + (i & 7));
+  ns = (cpu_ns() - start) / TIMED;
+  printf("predict: %.1f ns a reading (%ld alarms)\n", ns, raised);
+  if (ns > MAX_NS) {
+    fprintf(stderr, "predict: a reading took more than %d ns\n", MAX_NS);
+    failed = 1;
+  }
+  return failed;
+}
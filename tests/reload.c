@@ -0,0 +1,112 @@
+/*
+    tests/reload.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Reloads the configuration every 10 updates, once with a broken file and
+   once with a different one, and checks that every update still has its
+   readings and that the broken file leaves the old configuration loaded */
+
+#define main wmsensors_main
+#include "../wmsensors.c"
+#undef main
+#include "fakesensors.h"
+
+#define UPDATES 100
+
+static char config_name[] = "/tmp/wmsensors-reloadXXXXXX";
+
+static void write_config(const char *text)
+{
+  FILE *f = fopen(config_name, "w");
+
+  if (!f || fputs(text, f) == EOF || fclose(f)) {
+    perror(config_name);
+    exit(1);
+  }
+}
+
+static int chips_read(void)
+{
+  struct chip_reading r[MAX_CHIPS];
+  int i, n = reader_sample(r, MAX_CHIPS), got = 0;
+
+  for (i = 0; i < n; i++)
+    if (r[i].got)
+      got++;
+  return got;
+}
+
+int main(void)
+{
+  char line[256];
+  int fd, i, reloads = 0, lines = 0, marked = 0, failed = 0;
+
+  if ((fd = mkstemp(config_name)) < 0) {
+    perror(config_name);
+    return 1;
+  }
+  close(fd);
+  write_config("chips 3\n");
+  config_file_name = config_name;
+  open_config_file();
+  if (sensors_init(config_file)) {
+    fprintf(stderr, "reload: fake libsensors didn't load %s\n", config_name);
+    return 1;
+  }
+  KeepConfig(config_file);
+  reader_init();
+  hist_store_open(&history, NULL);
+  log_file = tmpfile();
+  log_status = 1;
+  count_printings = 1;
+
+  for (i = 0; i < UPDATES; i++) {
+    if (i == 40)
+      write_config("chips three\n");
+    else if (i == 60)
+      write_config("chips 2\n");
+    if (i % 10 == 5) {
+      reload_wanted = 1;
+      ReloadSensors();
+      reloads++;
+      if (i == 45 && chips_read() != 3) {
+	fprintf(stderr, "reload: a broken file didn't keep the old configuration\n");
+	failed = 1;
+      }
+      if (i == 65 && chips_read() != 2) {
+	fprintf(stderr, "reload: the new configuration wasn't loaded\n");
+	failed = 1;
+      }
+    }
+    InsertLm(0, 0);
+  }
+
+  /* One log line per update, and none of them short of readings */
+  rewind(log_file);
+  while (fgets(line, sizeof(line), log_file)) {
+    lines++;
+    if (line[0] == '#')
+      marked++;
+  }
+  printf("reload: %d updates, %d reloads, %d logged, %d missing readings\n",
+	 UPDATES, reloads, lines, marked);
+  if (lines != UPDATES || marked)
+    failed = 1;
+  unlink(config_name);
+  return failed;
+}
@@ -0,0 +1,110 @@
+/*
+    tests/steady.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Runs UPDATES updates, logging and keeping a history on disk as -r and
+   -z would, and counts the memory allocations they make, which should
+   be none. Each update is bracketed by getppid() calls, for syscount
+   to count the system calls it makes. With an argument the alarm
+   goes off on every update. */
+
+#define main wmsensors_main
+#include "../wmsensors.c"
+#undef main
+#include "fakesensors.h"
+
+#define WARMUP  100           /* to get past the first limits and blocks */
+#define UPDATES 1000
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+
+static int counting;
+static long allocations;
+
+void *malloc(size_t size)
+{
+  if (counting)
+    allocations++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+  if (counting)
+    allocations++;
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+  if (counting)
+    allocations++;
+  return __libc_realloc(p, size);
+}
+
+int main(int argc, char **argv)
+{
+  char dir[] = "/tmp/wmsensors-steadyXXXXXX", name[64];
+  FILE *config = tmpfile();
+  int i, alarm = argc > 1;
+
+  if (!config || fputs("chips 3\n", config) == EOF || !mkdtemp(dir)) {
+    perror("steady");
+    return 1;
+  }
+  rewind(config);
+  if (sensors_init(config)) {
+    fprintf(stderr, "steady: fake libsensors didn't load\n");
+    return 1;
+  }
+  fake_pread = 1;             /* libsensors reads a file per feature */
+  reader_init();
+  sprintf(name, "%s/history", dir);
+  if (hist_store_open(&history, name)) {
+    perror(name);
+    return 1;
+  }
+  log_file = fopen("/dev/null", "w");
+  log_status = 1;
+  if (alarm) {
+    ExecuteAlarm = "true";
+    command_init();
+    command_parse(&OnAlarm, ExecuteAlarm);
+    freopen("/dev/null", "w", stderr);   /* one "Alarm!" per update */
+  }
+
+  for (i = 0; i < WARMUP; i++)
+    InsertLm(0, alarm);
+  counting = 1;
+  for (i = 0; i < UPDATES; i++) {
+    getppid();
+    InsertLm(0, alarm);
+    getppid();
+  }
+  counting = 0;
+
+  printf("steady: %d updates%s, %ld allocations\n", UPDATES,
+	 alarm ? " with the alarm going off" : "", allocations);
+  unlink(name);
+  strcat(name, HIST_INDEX_SUFFIX);
+  unlink(name);
+  rmdir(dir);
+  return allocations != 0;
+}
@@ -0,0 +1,107 @@
+/*
+    tests/syscount.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* usage: syscount <mean> <worst> <program> [args...]
+   Runs the program under ptrace and counts the system calls it makes
+   between each pair of getppid() calls, which is to say in each update.
+   Fails if the updates average more than mean, if any one of them makes
+   more than worst, or if the program fails. Only x86 and x86-64 are
+   supported; elsewhere it says so and passes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <sys/user.h>
+#include <sys/syscall.h>
+
+#if defined(__x86_64__)
+#define SYSCALL_NR(r) ((r).orig_rax)
+#elif defined(__i386__)
+#define SYSCALL_NR(r) ((r).orig_eax)
+#endif
+
+int main(int argc, char **argv)
+{
+#ifdef SYSCALL_NR
+  struct user_regs_struct regs;
+  long total = 0, calls = 0, worst = 0, updates = 0, over = 0, max_worst;
+  double max_mean;
+  int status, counting = 0, entry = 1;
+  pid_t pid;
+
+  if (argc < 4) {
+    fprintf(stderr, "usage: syscount <mean> <worst> <program> [args...]\n");
+    return 2;
+  }
+  max_mean = atof(argv[1]);
+  max_worst = atol(argv[2]);
+  if ((pid = fork()) < 0) {
+    perror("syscount");
+    return 2;
+  }
+  if (!pid) {
+    ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+    execv(argv[3], argv + 3);
+    _exit(127);
+  }
+  waitpid(pid, &status, 0);    /* stopped at the exec */
+  ptrace(PTRACE_SETOPTIONS, pid, NULL, (void *)PTRACE_O_TRACESYSGOOD);
+  for (;;) {
+    ptrace(PTRACE_SYSCALL, pid, NULL, NULL);
+    if (waitpid(pid, &status, 0) < 0 || WIFEXITED(status)
+	|| WIFSIGNALED(status))
+      break;
+    if (!WIFSTOPPED(status) || WSTOPSIG(status) != (SIGTRAP | 0x80))
+      continue;
+    if (entry) {
+      ptrace(PTRACE_GETREGS, pid, NULL, &regs);
+      if (SYSCALL_NR(regs) != SYS_getppid) {
+	if (counting)
+	  calls++;
+      } else if ((counting = !counting))
+	calls = 0;
+      else {
+	/* The end of an update */
+	total += calls;
+	updates++;
+	if (calls > worst)
+	  worst = calls;
+	if (calls > max_worst)
+	  over++;
+      }
+    }
+    entry = !entry;
+  }
+  printf("syscount: %ld updates, %.1f system calls each, at most %ld"
+	 " (budget %g, at most %ld)\n", updates,
+	 updates ? (double)total / updates : 0.0, worst, max_mean, max_worst);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) || !updates)
+    return 1;
+  if (over)
+    fprintf(stderr, "syscount: %ld updates made more than %ld system calls\n",
+	    over, max_worst);
+  return over || total > max_mean * updates;
+#else
+  printf("syscount: not supported on this architecture\n");
+  return 0;
+#endif
+}
@@ -0,0 +1,138 @@
+/*
+    trace.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include "trace.h"
+
+struct trace_event {
+  long long ts;                /* microseconds, CLOCK_MONOTONIC */
+  long arg;
+  int tid;
+  short point;
+  char phase;                  /* 'B' or 'E' */
+};
+
+static const char *names[NTRACEPOINTS] = {
+  "tick", "read", "chip", "limits", "convert", "draw", "flush", "log",
+  "alarm"
+};
+
+/* What the argument of each step means, or NULL if it has none */
+static const char *arg_names[NTRACEPOINTS] = {
+  NULL, NULL, "chip", NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+int trace_on;
+static const char *dump_filename;
+static struct trace_event *events;
+static unsigned long next_event;
+static int next_tid;
+static __thread int tid;
+static volatile sig_atomic_t dump_wanted;
+
+static void dump_signal(int sig)
+{
+  dump_wanted = 1;
+}
+
+/*****************************************************************************/
+/* Sets aside the event ring and starts recording. The trace is written to
+   filename on SIGUSR1 and at exit. */
+int trace_open(const char *filename)
+{
+  struct sigaction sa;
+
+  /* Touch every page now rather than on some later update */
+  if (!(events = calloc(TRACE_EVENTS, sizeof(*events))))
+    return -1;
+  memset(events, 0, TRACE_EVENTS * sizeof(*events));
+  dump_filename = filename;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = dump_signal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGUSR1, &sa, NULL);
+  atexit(trace_dump);
+  trace_on = 1;
+  return 0;
+}
+
+/* Records one event. Safe from any thread; if the ring is full the
+   oldest event is overwritten. */
+void trace_event(int point, int phase, long arg)
+{
+  struct trace_event *e;
+  struct timespec now;
+
+  if (!tid)
+    tid = __sync_add_and_fetch(&next_tid, 1);
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  e = &events[__sync_fetch_and_add(&next_event, 1) % TRACE_EVENTS];
+  e->ts = now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+  e->arg = arg;
+  e->tid = tid;
+  e->point = point;
+  e->phase = phase;
+}
+
+/* Called from the main loop: writes the trace if SIGUSR1 asked for it */
+void trace_poll(void)
+{
+  if (dump_wanted) {
+    dump_wanted = 0;
+    trace_dump();
+  }
+}
+
+/*****************************************************************************/
+/* Writes every event in the ring, oldest first */
+void trace_dump(void)
+{
+  struct trace_event *e;
+  unsigned long i, first, last = next_event;
+  int pid = getpid(), n = 0;
+  FILE *f;
+
+  if (!trace_on)
+    return;
+  if (!(f = fopen(dump_filename, "w"))) {
+    perror(dump_filename);
+    return;
+  }
+  first = last > TRACE_EVENTS ? last - TRACE_EVENTS : 0;
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (i = first; i < last; i++) {
+    e = &events[i % TRACE_EVENTS];
+    if (e->point < 0 || e->point >= NTRACEPOINTS)
+      continue;
+    fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"wmsensors\",\"ph\":\"%c\","
+	    "\"ts\":%lld,\"pid\":%d,\"tid\":%d", n++ ? ",\n" : "",
+	    names[e->point], e->phase, e->ts, pid, e->tid);
+    if (arg_names[e->point])
+      fprintf(f, ",\"args\":{\"%s\":%ld}", arg_names[e->point], e->arg);
+    fputc('}', f);
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+}
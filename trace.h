@@ -0,0 +1,74 @@
+/*
+    trace.h - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef WMSENSORS_TRACE_H
+#define WMSENSORS_TRACE_H
+
+/*************************************************************************/
+/* Tracing of each update, for finding the slow ones. With -t the begin  */
+/* and end of every step go into a fixed ring of events, which is        */
+/* written out in Chrome's trace event format (load it in                */
+/* chrome://tracing or Perfetto) on SIGUSR1 and at exit. Built with      */
+/* -DHAVE_SYS_SDT_H every step is also a USDT probe, eg.                 */
+/* wmsensors:chip_begin, for perf and bpftrace. Without -t a step costs  */
+/* a test of trace_on.                                                   */
+/*************************************************************************/
+
+#define TRACE_EVENTS 65536        /* events kept; older ones are lost */
+
+/* The steps traced. TRACE_BEGIN(chip, n) records TP_chip. */
+#define TP_tick    0              /* a whole update */
+#define TP_read    1              /* reading every chip */
+#define TP_chip    2              /* reading one chip; arg is its number */
+#define TP_limits  3              /* reading the limits */
+#define TP_convert 4              /* working out the pixels */
+#define TP_draw    5              /* drawing into the pixmap */
+#define TP_flush   6              /* XFlush() */
+#define TP_log     7              /* writing the -r log */
+#define TP_alarm   8              /* running the alarm command */
+#define NTRACEPOINTS 9
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define TRACE_PROBE(name, phase, arg) \
+  DTRACE_PROBE1(wmsensors, name##_##phase, (long)(arg))
+#else
+#define TRACE_PROBE(name, phase, arg)
+#endif
+
+#define TRACE_BEGIN(name, arg) do {		\
+    TRACE_PROBE(name, begin, arg);		\
+    if (trace_on)				\
+      trace_event(TP_##name, 'B', arg);		\
+  } while (0)
+
+#define TRACE_END(name, arg) do {		\
+    TRACE_PROBE(name, end, arg);		\
+    if (trace_on)				\
+      trace_event(TP_##name, 'E', arg);		\
+  } while (0)
+
+extern int trace_on;
+
+int trace_open(const char *filename);
+void trace_event(int point, int phase, long arg);
+void trace_poll(void);
+void trace_dump(void);
+
+#endif /* WMSENSORS_TRACE_H */
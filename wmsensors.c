@@ -25,13 +25,26 @@
 #include <X11/xpm.h>
 #include <X11/extensions/shape.h>
 #include <time.h>
+#include <sys/time.h>
 #include <errno.h>
 #include <math.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <X11/Xatom.h>
 #include "sensors/sensors.h"
 #include "sensors/chips.h"
 #include "sensors/error.h"
+#include "sample.h"
+#include "history.h"
+#include "hwmon.h"
+#include "reader.h"
+#include "stream.h"
+#include "graph.h"
+#include "trace.h"
+#include "control.h"
+#include "predict.h"
+#include "spawn.h"
 
 #include "back.xpm"
 #include "mask2.xbm"
@@ -44,6 +57,7 @@
 #define FALSE 0
 #define Shape(num) (ONLYSHAPE ? num-5 : num)
 #define DEFAULT_CONFIG_FILE_NAME "sensors.conf"
+#define LIMITS_EVERY 60   /* updates between readings of the limits */
 
 /* Global Data storage/structures ********************************************/
 int ONLYSHAPE=0; /* default value is noshape */
@@ -55,7 +69,14 @@ static char *help_message[] = {
 "    -u <secs>               updatespeed",
 "    -e <program>            program to start on middle-click",
 "    -p [+|-]x[+|-]y         position of wmsensors",
+"    -V <layout>[@display]   add a view: all, temp, volt or fan graphs",
 "    -r [filename]           record data in a log file",
+"    -z <filename>           keep a compressed history in filename",
+"    -j <filename>           stream JSON Lines to filename (- for stdout)",
+"    -o oldest|newest|coalesce  what -j drops when the reader falls behind",
+"    -t <filename>           trace each update to filename (on SIGUSR1 and exit)",
+"    -C <fifo>               take commands from the FIFO (reload, update, alarm, log)",
+"    -H <secs>               alarm when a reading is heading past a limit within secs",
 "    -s                      without groundplate",
 "    -i                      start up as icon",
 "    -w                      start up withdrawn",
@@ -64,34 +85,41 @@ NULL
 };
 
 /* X11 Variables *************************************************************/
-Display *dpy;	  /* which DISPLAY */
-Window Root;      /* Background-Drawable */
-int screen;
-int x_fd;
-int d_depth;
-XSizeHints mysizehints;
 XWMHints mywmhints;
-Pixel back_pix, fore_pix;
-GC NormalGC;
-Window iconwin, win;       /* My home is my window */
 char *ProgName;
 char *Geometry;
 char *LedColor = "LightSeaGreen";
 
 /* Thanks to Lars Kellogg-Stedman for removing a kluge from the next line */
-char Execute1[] = "x-terminal-emulator -T wmsensors -e sh -c 'sensors | less' &";
+char *Execute1 = "x-terminal-emulator -T wmsensors -e sh -c 'sensors | less' &";
 
-char Execute2[] = "/usr/bin/sensors -s";
-char Execute3[] = "x-terminal-emulator -T wmsensors -e man wmsensors &";
+char *Execute2 = "/usr/bin/sensors -s";
+char *Execute3 = "x-terminal-emulator -T wmsensors -e man wmsensors &";
 char *ExecuteAlarm;
+/* The same, ready to run */
+struct command OnClick[3], OnAlarm;
 char *ERR_colorcells = "not enough free color cells\n";
-char *ampers = " &";
 static char *config_file_name;
 FILE *config_file;
+FILE *good_config;      /* copy of the last configuration that loaded */
 FILE *log_file;
 char *log_filename;
 int log_status;
 int count_printings = 0;
+struct hist_store history;
+char *history_filename;
+char *stream_target;
+char *trace_filename;
+char *control_fifo;
+volatile sig_atomic_t reload_wanted;
+volatile sig_atomic_t quit_wanted;     /* SIGTERM or SIGINT */
+int limits_wanted = 1;     /* re-read the limits at the next update */
+int control_ready = 1;     /* poll() says there may be commands waiting */
+int hwmon_opened;
+double predict_horizon;   /* 0 for no predictive alarms */
+struct trend trends[NCHANNELS];
+struct sample shown;       /* the last good reading of each channel */
+int stream_overflow = STREAM_DROP_OLDEST;
 static const char *config_file_path[] =
 { "/etc", "/usr/lib/sensors", "/usr/local/lib/sensors", "/usr/lib",
   "/usr/local/lib", ".", 0 };
@@ -103,17 +131,49 @@ typedef struct _XpmIcon {
     XpmAttributes attributes;
 }        XpmIcon;
 
-XpmIcon wmsensors;
-XpmIcon visible;
+/* One window pair (a dock tile), with its own connection to its display.
+   Every view draws the same samples; its layout picks which graphs. */
+#define MAX_VIEWS 8
+
+typedef struct _View {
+    char *display_name;        /* NULL for $DISPLAY */
+    int channels;              /* LAYOUT_... */
+    Display *dpy;	       /* which DISPLAY, or NULL once closed */
+    Window Root;               /* Background-Drawable */
+    int screen;
+    int x_fd;
+    int d_depth;
+    XSizeHints mysizehints;
+    Pixel back_pix, fore_pix;
+    GC NormalGC;
+    Window iconwin, win;       /* My home is my window */
+    XpmIcon wmsensors;
+    XpmIcon visible;
+    int readable;              /* poll() says the server sent something */
+} View;
+
+View views[MAX_VIEWS];
+int nviews, nopen;
 time_t actualtime;
 long actualmin;
 
 /* Function definitions ******************************************************/
-void GetXPM(void);
-Pixel GetColor(char *name);
-void RedrawWindow( XpmIcon *v);
-void InitLm();
-void InsertLm();
+void GetXPM(View *v);
+Pixel GetColor(View *v, char *name);
+void RedrawWindow(View *v);
+void OpenView(View *v, int argc, char *argv[]);
+int EarlierViews(View *v);
+void CloseView(View *v, Window gone);
+void Quit(int status);
+int EventsWaiting(View *v);
+void InitLm(View *v);
+void InsertLm(int multiple_lm75, int AlarmRequired);
+void DrawLm(View *v, const struct graph_point *points, int npoints);
+void HwmonAlarm(const char *which, int notified);
+void LogWrite(const char *buf, int n);
+void KeepConfig(FILE *f);
+void ReloadSensors(void);
+void Control(int cmd, const char *arg);
 
 /*****************************************************************************/
 /* Source Code <--> Function Implementations                                 */
@@ -185,19 +245,36 @@ int AlarmStatus;  /* Audible beeps should be on by default as they */
 int AlarmFlag;    /* This is the "Current alarms" flag             */
 int AlarmBeeping; /* This shows whether the alarm is on            */
 
+static void hangup(int sig)
+{
+  reload_wanted = 1;
+}
+
+static void terminate(int sig)
+{
+  quit_wanted = 1;
+}
+
+/* Xlib exits when this returns, so the history has to be saved here */
+static int LostDisplay(Display *dpy)
+{
+  fprintf(stderr,"wmsensors: lost the connection to %s\n", DisplayString(dpy));
+  Quit(1);
+  return 0;
+}
+
 int main(int argc,char *argv[])
 {
   int res, i;
+  char *layout;
   int multiple_lm75 = 0;
-  unsigned int borderwidth ;
-  char *display_name = NULL; 
-  char *wname = "wmsensors";
-  XGCValues gcv;
-  unsigned long gcm;
   XEvent Event;
-  XTextProperty name;
-  XClassHint classHint;
-  Pixmap pixmask;
+  View *v;
+  struct pollfd pfd[MAX_VIEWS + 2 + MAX_HWMON_ALARMS];
+  const char *which, *arg;
+  int nx, nctl, nstream, nalarm, cmd, timeout;
+  time_t last_update = 0;
+  struct timeval now;
 
   Geometry = "";
   mywmhints.initial_state = NormalState;
@@ -240,10 +317,33 @@ int main(int argc,char *argv[])
 	    fprintf(stderr,"Unable to write log file. Continuing anyway...\n");
 	  }
 	continue;
+      case 'z':
+        if(++i >=argc) usage();
+        history_filename = argv[i];
+        continue;
+      case 'j':
+        if(++i >=argc) usage();
+        stream_target = argv[i];
+        continue;
+      case 'o':
+        if(++i >=argc) usage();
+        if ((stream_overflow = stream_policy(argv[i])) < 0) usage();
+        continue;
+      case 't':
+        if(++i >=argc) usage();
+        trace_filename = argv[i];
+        continue;
+      case 'H':
+        if(++i >=argc) usage();
+        sscanf(argv[i], "%lf", &predict_horizon);
+        continue;
+      case 'C':
+        if(++i >=argc) usage();
+        control_fifo = argv[i];
+        continue;
       case 'e':
         if(++i >=argc) usage();
-        strcpy(&Execute2[0], argv[i]);
-        strcat(&Execute2[0], " &");
+        Execute2 = argv[i];
         continue;
       case 's':
         ONLYSHAPE=1;
@@ -252,6 +352,15 @@ int main(int argc,char *argv[])
         if(++i >=argc) usage();
         Geometry = argv[i];
         continue;
+      case 'V':
+        if(++i >=argc || nviews == MAX_VIEWS) usage();
+        /* A copy, so argv still says what we were started with */
+        layout = strdup(argv[i]);
+        if ((views[nviews].display_name = strchr(layout, '@')))
+          *views[nviews].display_name++ = '\0';
+        if (!(views[nviews].channels = graph_layout(layout))) usage();
+        nviews++;
+        continue;
       case 'i':
         mywmhints.initial_state = IconicState;
         continue;
@@ -279,88 +388,49 @@ int main(int argc,char *argv[])
         usage();
       }
   }
-  /* Open the display */
-  if (!(dpy = XOpenDisplay(display_name)))  
-    { 
-      fprintf(stderr,"wmsensors: can't open display %s\n", 
-	      XDisplayName(display_name)); 
-      exit (1); 
-    } 
-
-    if (log_status)
-      fprintf(log_file, "temp1 temp2 temp3 in0  in1  in2  in3  in4   in5    in6   fan1    fan2    fan3\n");
-
-  screen= DefaultScreen(dpy);
-  Root = RootWindow(dpy, screen);
-  d_depth = DefaultDepth(dpy, screen);
-  x_fd = XConnectionNumber(dpy);
-  
-  /* Convert XPM Data to XImage */
-  GetXPM();
-  
-  /* Create a window to hold the banner */
-  mysizehints.flags= USSize|USPosition;
-  mysizehints.x = 0;
-  mysizehints.y = 0;
-
-  back_pix = GetColor("white");
-  fore_pix = GetColor("black");
-
-  XWMGeometry(dpy, screen, Geometry, NULL, (borderwidth =1), &mysizehints,
-	      &mysizehints.x,&mysizehints.y,&mysizehints.width,&mysizehints.height, &i); 
-
-  mysizehints.width = wmsensors.attributes.width;
-  mysizehints.height= wmsensors.attributes.height;
-
-  win = XCreateSimpleWindow(dpy,Root,mysizehints.x,mysizehints.y,
-			    mysizehints.width,mysizehints.height,
-			    borderwidth,fore_pix,back_pix);
-  iconwin = XCreateSimpleWindow(dpy,win,mysizehints.x,mysizehints.y,
-				mysizehints.width,mysizehints.height,
-				borderwidth,fore_pix,back_pix);
-
-  /* activate hints */
-  XSetWMNormalHints(dpy, win, &mysizehints);
-  classHint.res_name =  "wmsensors";
-  classHint.res_class = "WMSensors";
-  XSetClassHint(dpy, win, &classHint);
+  if (!nviews)
+    views[nviews++].channels = LAYOUT_ALL;
+
+  /* Open the displays */
+  XSetIOErrorHandler(LostDisplay);
+  for (i = 0; i < nviews; i++)
+    if (!(views[i].dpy = XOpenDisplay(views[i].display_name)))  
+      { 
+	fprintf(stderr,"wmsensors: can't open display %s\n", 
+		XDisplayName(views[i].display_name)); 
+	exit (1); 
+      } 
+  nopen = nviews;
+
+    if (log_status) {
+      fprintf(log_file, LOG_HEADER);
+      fflush(log_file);
+    }
 
-  XSelectInput(dpy,win,MW_EVENTS);
-  XSelectInput(dpy,iconwin,MW_EVENTS);
-  XSetCommand(dpy,win,argv,argc);
-  
-  if (XStringListToTextProperty(&wname, 1, &name) ==0) {
-    fprintf(stderr, "wmsensors: can't allocate window name\n");
-    exit(-1);
-  }
-  XSetWMName(dpy, win, &name);
-  
-  /* Create a GC for drawing */
-  gcm = GCForeground|GCBackground|GCGraphicsExposures;
-  gcv.foreground = fore_pix;
-  gcv.background = back_pix;
-  gcv.graphics_exposures = FALSE;
-  NormalGC = XCreateGC(dpy, Root, gcm, &gcv);  
+  /* Commands are split up once, here, rather than each time they run */
+  command_init();
+  if (command_parse(&OnClick[0], Execute1) || command_parse(&OnClick[1], Execute2)
+      || command_parse(&OnClick[2], Execute3) || command_parse(&OnAlarm, ExecuteAlarm))
+    fprintf(stderr,"wmsensors: command too long, ignored\n");
 
-  if (ONLYSHAPE) { /* try to make shaped window here */
-    pixmask = XCreateBitmapFromData(dpy, win, mask2_bits, mask2_width, 
-				    mask2_height);
-    XShapeCombineMask(dpy, win, ShapeBounding, 0, 0, pixmask, ShapeSet);
-    XShapeCombineMask(dpy, iconwin, ShapeBounding, 0, 0, pixmask, ShapeSet);
+  if (hist_store_open(&history, history_filename)) {
+    fprintf(stderr,"Unable to write history file. Continuing anyway...\n");
+    hist_store_open(&history, NULL);
   }
-  
-  mywmhints.icon_window = iconwin;
-  mywmhints.icon_x = mysizehints.x;
-  mywmhints.icon_y = mysizehints.y;
-  mywmhints.window_group = win;
-  mywmhints.flags = StateHint | IconWindowHint | IconPositionHint
-      | WindowGroupHint;
-  XSetWMHints(dpy, win, &mywmhints); 
-
-  XMapWindow(dpy,win);
-  InitLm();
-  InsertLm();
-  RedrawWindow(&visible);
+  if (stream_target && stream_open(stream_target, stream_overflow))
+    fprintf(stderr,"Unable to open stream output. Continuing anyway...\n");
+  if (trace_filename && trace_open(trace_filename))
+    fprintf(stderr,"Unable to start tracing. Continuing anyway...\n");
+  if (control_fifo && control_open(control_fifo))
+    fprintf(stderr,"Unable to open control FIFO. Continuing anyway...\n");
+
+  for (i = 0; i < nviews; i++)
+    OpenView(&views[i], argc, argv);
+  /* Show the empty panels while libsensors loads. Nothing is sampled
+     until it has, so the history, log and stream start with the first
+     real readings; the loop below takes them straight away. */
+  for (i = 0; i < nviews; i++)
+    RedrawWindow(&views[i]);
 
   open_config_file(); /* Now we must initialise the sensors library */
   if ((res = sensors_init(config_file)))
@@ -373,64 +443,125 @@ int main(int argc,char *argv[])
       fprintf(stderr,"%s\n",sensors_strerror(res));
     exit(1);
   }
-
+  if (config_file != stdin)
+    KeepConfig(config_file);
+  reader_init();
+  signal(SIGHUP, hangup);
+  signal(SIGTERM, terminate);
+  signal(SIGINT, terminate);
+
+  /* Alarms the kernel tells us about don't have to wait for a sample */
+  if (AlarmStatus) {
+    hwmon_alarms_open(HWMON_DIR);
+    hwmon_opened = 1;
+  }
   while(1)
     {
+      if (quit_wanted)
+	Quit(0);
+      /* Configuration changes go in between updates */
+      while (control_ready && (cmd = control_next(&arg)) != CTL_NONE)
+	Control(cmd, arg);
+      control_ready = 0;
+      if (reload_wanted)
+	ReloadSensors();
+
       if (actualtime != time(0))
 	{
 	  actualtime = time(0);
 	  
-	  if(actualtime % updatespeed == 0)
+	  /* An update that came due while we were held up (by a slow
+	     reload, say) is made late rather than missed */
+	  if(actualtime % updatespeed == 0
+	     || actualtime - last_update >= updatespeed) {
+	    last_update = actualtime;
+	    TRACE_BEGIN(tick, 0);
 	    InsertLm(multiple_lm75, AlarmStatus);
+	    if (AlarmStatus && hwmon_alarms_recheck(&which))
+	      HwmonAlarm(which, 0);
+	    TRACE_END(tick, 0);
+	  }
 
-	  RedrawWindow(&visible);
+	  for (i = 0; i < nviews; i++)
+	    if (views[i].dpy)
+	      RedrawWindow(&views[i]);
 	}
       
-      /* read a packet */
-      while (XPending(dpy))
-	{
-	  XNextEvent(dpy,&Event);
-	  switch(Event.type)
-	    {
-	    case Expose:
-	      if(Event.xexpose.count == 0 )
-		RedrawWindow(&visible);
-	      break;
-	    case ButtonPress:
-              if (AlarmFlag && AlarmBeeping)
+      /* read the packets from each view */
+      for (v = views; v < views + nviews; v++)
+	while (EventsWaiting(v))
+	  {
+	    XNextEvent(v->dpy,&Event);
+	    switch(Event.type)
 	      {
-		AlarmFlag = 0;
+	      case Expose:
+		if(Event.xexpose.count == 0 )
+		  RedrawWindow(v);
 		break;
-	      }
-	      switch(Event.xbutton.button) {
-	        case Button1:
-		  system(Execute1);
+	      case ButtonPress:
+		if (AlarmFlag && AlarmBeeping)
+		{
+		  AlarmFlag = 0;
 		  break;
-	        case Button2:
-		  system(Execute2);
-	        case Button3:
-		  system(Execute3);
-		  break;
-	        default:
+		}
+		switch(Event.xbutton.button) {
+		  case Button1:
+		    command_run(&OnClick[0]);
+		    break;
+		  case Button2:
+		    command_run(&OnClick[1]);
+		    limits_wanted = 1;  /* sensors -s sets them */
+		  case Button3:
+		    command_run(&OnClick[2]);
+		    break;
+		  default:
+		    break;
+		}
+		break;
+	      case DestroyNotify:
+		CloseView(v, Event.xdestroywindow.window);
+		if (nopen)
 		  break;
+		Quit(0);
+	      default:
+		break;      
 	      }
-	      break;
-	    case DestroyNotify:
-              XFreeGC(dpy, NormalGC);
-              XDestroyWindow(dpy, win);
-	      XDestroyWindow(dpy, iconwin);
-              XCloseDisplay(dpy);
-	      exit(0); 
-	    default:
-	      break;      
-	    }
+	  }
+      TRACE_BEGIN(flush, 0);
+      for (i = 0; i < nviews; i++)
+	if (views[i].dpy)
+	  XFlush(views[i].dpy);
+      TRACE_END(flush, 0);
+
+      /* Sleep until the next second, when the next update or redraw may be
+	 due, or until X, a command or an alarm wakes us. Signals (SIGHUP,
+	 SIGUSR1) wake us too. */
+      gettimeofday(&now, NULL);
+      timeout = 1000 - now.tv_usec / 1000;
+      for (i = nx = 0; i < nviews; i++)
+	if (views[i].dpy) {
+	  pfd[nx].fd = views[i].x_fd;
+	  pfd[nx].events = POLLIN;
+	  nx++;
+	  if (XQLength(views[i].dpy))
+	    timeout = 0;       /* read while we were sending */
 	}
-      XFlush(dpy);
-#ifdef SYSV
-      poll((struct poll *) 0, (size_t) 0, 50);
-#else
-      usleep(50000L);			/* 5/100 sec */
-#endif
+      nctl = control_pollfd(&pfd[nx]);
+      nstream = stream_pollfd(&pfd[nx + nctl]);
+      nalarm = hwmon_alarms_pollfds(pfd + nx + nctl + nstream, MAX_HWMON_ALARMS);
+      if (poll(pfd, nx + nctl + nstream + nalarm, timeout) > 0)
+	{
+	  for (i = nx = 0; i < nviews; i++)
+	    if (views[i].dpy)
+	      views[i].readable = pfd[nx++].revents != 0;
+	  control_ready = nctl && pfd[nx].revents;
+	  if (nstream && pfd[nx + nctl].revents)
+	    stream_flush();
+	  if (hwmon_alarms_notified(pfd + nx + nctl + nstream, nalarm, &which)
+	      && AlarmStatus)
+	    HwmonAlarm(which, 1);
+	}
+      trace_poll();
     }
   return 0;
 }
@@ -443,22 +574,20 @@ void nocolor(char *a, char *b)
 
 /*****************************************************************************/
 /* convert the XPMIcons to XImage */
-void GetXPM(void)
+void GetXPM(View *v)
 {
   static char **alt_xpm;
   XColor col;
   XWindowAttributes attributes;
-  int ret;
-  char tempc1[12],tempc2[12],tempc3[12],tempc4[12],tempc5[12],tempc6[12],tempc7[12];
-  float colr,colg,colb;
+  int ret, i;
 
   alt_xpm =ONLYSHAPE ? mask_xpm : back_xpm;
 
   /* for the colormap */
-  XGetWindowAttributes(dpy,Root,&attributes);
+  XGetWindowAttributes(v->dpy,v->Root,&attributes);
 
   /* get user-defined color or validate the default */
-  if (!XParseColor (dpy, attributes.colormap, LedColor, &col)) 
+  if (!XParseColor (v->dpy, attributes.colormap, LedColor, &col)) 
     {
       nocolor("parse",LedColor);
     }
@@ -467,59 +596,19 @@ void GetXPM(void)
       /* Make 7 distinct colours (this may as well be done in the xpm
          now because they will not be changeable (7 colours all
          changeable would get horrible) */
-
-      colr = 255;
-      colg = 255;
-      colb = 0;
-      sprintf(tempc1, "W c #%.2x%.2x%.2x", (int)colr, (int)colg, (int)colb);
-      back_xpm[51] = tempc1;
-
-      colr = 255;
-      colg = 127;
-      colb = 0;
-      sprintf(tempc2, "V c #%.2x%.2x%.2x", (int)colr, (int)colg, (int)colb);
-      back_xpm[50] = tempc2;
-
-      colr = 0;
-      colg = 255;
-      colb = 255;
-      sprintf(tempc3, "U c #%.2x%.2x%.2x", (int)colr, (int)colg, (int)colb);
-      back_xpm[49] = tempc3;
-
-      colr = 208;
-      colg = 0;
-      colb = 255;
-      sprintf(tempc4, "T c #%.2x%.2x%.2x", (int)colr, (int)colg, (int)colb);
-      back_xpm[48] = tempc4;
-
-      colr = 196;
-      colg = 196;
-      colb = 196;
-      sprintf(tempc5, "S c #%.2x%.2x%.2x", (int)colr, (int)colg, (int)colb);
-      back_xpm[47] = tempc5;
-
-      colr = 0;
-      colg = 255;
-      colb = 0;
-      sprintf(tempc6, "R c #%.2x%.2x%.2x", (int)colr, (int)colg, (int)colb);
-      back_xpm[46] = tempc6;
-
-      colr = 255;
-      colg = 0;
-      colb = 0;
-      sprintf(tempc7, "Q c #%.2x%.2x%.2x", (int)colr, (int)colg, (int)colb);
-      back_xpm[45] = tempc7;
+      for (i = 0; i < NGRAPH_COLOURS; i++)
+        back_xpm[GRAPH_COLOURS_AT + i] = (char *)graph_colours[i];
     }
 
-  wmsensors.attributes.valuemask |= (XpmReturnPixels | XpmReturnExtensions);
-  ret = XpmCreatePixmapFromData(dpy, Root, alt_xpm, &wmsensors.pixmap, 
-				&wmsensors.mask, &wmsensors.attributes);
+  v->wmsensors.attributes.valuemask |= (XpmReturnPixels | XpmReturnExtensions);
+  ret = XpmCreatePixmapFromData(v->dpy, v->Root, alt_xpm, &v->wmsensors.pixmap, 
+				&v->wmsensors.mask, &v->wmsensors.attributes);
   if(ret != XpmSuccess)
     {fprintf(stderr, ERR_colorcells);exit(1);}
 
-  visible.attributes.valuemask |= (XpmReturnPixels | XpmReturnExtensions);
-  ret = XpmCreatePixmapFromData(dpy, Root, back_xpm, &visible.pixmap, 
-				&visible.mask, &visible.attributes);
+  v->visible.attributes.valuemask |= (XpmReturnPixels | XpmReturnExtensions);
+  ret = XpmCreatePixmapFromData(v->dpy, v->Root, back_xpm, &v->visible.pixmap, 
+				&v->visible.mask, &v->visible.attributes);
   if(ret != XpmSuccess)
     {fprintf(stderr, ERR_colorcells);exit(1);}
 
@@ -527,7 +616,7 @@ void GetXPM(void)
 
 /*****************************************************************************/
 /* Removes expose events for a specific window from the queue */
-int flush_expose (Window w)
+int flush_expose (Display *dpy, Window w)
 {
   XEvent dummy;
   int i=0;
@@ -538,30 +627,32 @@ int flush_expose (Window w)
 
 /*****************************************************************************/
 /* Draws the icon window */
-void RedrawWindow( XpmIcon *v)
+void RedrawWindow(View *v)
 {
-  flush_expose (iconwin);
-  XCopyArea(dpy,v->pixmap,iconwin,NormalGC,
-	    0,0,v->attributes.width, v->attributes.height,0,0);
-  flush_expose (win);
-  XCopyArea(dpy,v->pixmap,win,NormalGC,
-	    0,0,v->attributes.width, v->attributes.height,0,0);
+  XpmIcon *icon = &v->visible;
+
+  flush_expose (v->dpy, v->iconwin);
+  XCopyArea(v->dpy,icon->pixmap,v->iconwin,v->NormalGC,
+	    0,0,icon->attributes.width, icon->attributes.height,0,0);
+  flush_expose (v->dpy, v->win);
+  XCopyArea(v->dpy,icon->pixmap,v->win,v->NormalGC,
+	    0,0,icon->attributes.width, icon->attributes.height,0,0);
 
 }
 
 /*****************************************************************************/
-Pixel GetColor(char *name)
+Pixel GetColor(View *v, char *name)
 {
   XColor color;
   XWindowAttributes attributes;
 
-  XGetWindowAttributes(dpy,Root,&attributes);
+  XGetWindowAttributes(v->dpy,v->Root,&attributes);
   color.pixel = 0;
-   if (!XParseColor (dpy, attributes.colormap, name, &color)) 
+   if (!XParseColor (v->dpy, attributes.colormap, name, &color)) 
      {
        nocolor("parse",name);
      }
-   else if(!XAllocColor (dpy, attributes.colormap, &color)) 
+   else if(!XAllocColor (v->dpy, attributes.colormap, &color)) 
      {
        nocolor("alloc",name);
      }
@@ -569,56 +660,213 @@ Pixel GetColor(char *name)
 }
 
 /*****************************************************************************/
+/* Makes the windows for a view whose display is already open */
+void OpenView(View *v, int argc, char *argv[])
+{
+  unsigned int borderwidth;
+  char *wname = "wmsensors";
+  XGCValues gcv;
+  unsigned long gcm;
+  XTextProperty name;
+  XClassHint classHint;
+  Pixmap pixmask;
+  int i, offset;
+
+  v->screen= DefaultScreen(v->dpy);
+  v->Root = RootWindow(v->dpy, v->screen);
+  v->d_depth = DefaultDepth(v->dpy, v->screen);
+  v->x_fd = XConnectionNumber(v->dpy);
+  
+  /* Convert XPM Data to XImage */
+  GetXPM(v);
+  
+  /* Create a window to hold the banner */
+  v->mysizehints.flags= USSize|USPosition;
+  v->mysizehints.x = 0;
+  v->mysizehints.y = 0;
 
-void InitLm()
+  v->back_pix = GetColor(v, "white");
+  v->fore_pix = GetColor(v, "black");
+
+  XWMGeometry(v->dpy, v->screen, Geometry, NULL, (borderwidth =1), &v->mysizehints,
+	      &v->mysizehints.x,&v->mysizehints.y,&v->mysizehints.width,&v->mysizehints.height, &i); 
+
+  v->mysizehints.width = v->wmsensors.attributes.width;
+  v->mysizehints.height= v->wmsensors.attributes.height;
+
+  /* Views on the same display go side by side, away from the corner -p
+     was measured from, rather than on top of each other */
+  offset = EarlierViews(v) * v->mysizehints.width;
+  if (i == NorthEastGravity || i == SouthEastGravity)
+    offset = -offset;
+  v->mysizehints.x += offset;
+
+  v->win = XCreateSimpleWindow(v->dpy,v->Root,v->mysizehints.x,v->mysizehints.y,
+			    v->mysizehints.width,v->mysizehints.height,
+			    borderwidth,v->fore_pix,v->back_pix);
+  v->iconwin = XCreateSimpleWindow(v->dpy,v->win,v->mysizehints.x,v->mysizehints.y,
+				v->mysizehints.width,v->mysizehints.height,
+				borderwidth,v->fore_pix,v->back_pix);
+
+  /* activate hints */
+  XSetWMNormalHints(v->dpy, v->win, &v->mysizehints);
+  classHint.res_name =  "wmsensors";
+  classHint.res_class = "WMSensors";
+  XSetClassHint(v->dpy, v->win, &classHint);
+
+  XSelectInput(v->dpy,v->win,MW_EVENTS);
+  XSelectInput(v->dpy,v->iconwin,MW_EVENTS);
+  if (v == views)
+    XSetCommand(v->dpy,v->win,argv,argc);  /* one command for them all */
+  
+  if (XStringListToTextProperty(&wname, 1, &name) ==0) {
+    fprintf(stderr, "wmsensors: can't allocate window name\n");
+    exit(-1);
+  }
+  XSetWMName(v->dpy, v->win, &name);
+  
+  /* Create a GC for drawing */
+  gcm = GCForeground|GCBackground|GCGraphicsExposures;
+  gcv.foreground = v->fore_pix;
+  gcv.background = v->back_pix;
+  gcv.graphics_exposures = FALSE;
+  v->NormalGC = XCreateGC(v->dpy, v->Root, gcm, &gcv);  
+
+  if (ONLYSHAPE) { /* try to make shaped window here */
+    pixmask = XCreateBitmapFromData(v->dpy, v->win, mask2_bits, mask2_width, 
+				    mask2_height);
+    XShapeCombineMask(v->dpy, v->win, ShapeBounding, 0, 0, pixmask, ShapeSet);
+    XShapeCombineMask(v->dpy, v->iconwin, ShapeBounding, 0, 0, pixmask, ShapeSet);
+  }
+  
+  mywmhints.icon_window = v->iconwin;
+  mywmhints.icon_x = v->mysizehints.x;
+  mywmhints.icon_y = v->mysizehints.y;
+  mywmhints.window_group = v->win;
+  mywmhints.flags = StateHint | IconWindowHint | IconPositionHint
+      | WindowGroupHint;
+  XSetWMHints(v->dpy, v->win, &mywmhints); 
+
+  XMapWindow(v->dpy,v->win);
+  v->readable = 1;
+  InitLm(v);
+}
+
+/* How many of the views before v are on the same display */
+int EarlierViews(View *v)
+{
+  View *w;
+  int n = 0;
+
+  for (w = views; w < v; w++)
+    if (w->display_name == v->display_name
+	|| (w->display_name && v->display_name
+	    && !strcmp(w->display_name, v->display_name)))
+      n++;
+  return n;
+}
+
+/* Whether v has events to handle. The server is only asked when poll()
+   has seen it send something, so an idle view costs no system calls. */
+int EventsWaiting(View *v)
+{
+  if (!v->dpy)
+    return 0;
+  if (XQLength(v->dpy))
+    return 1;
+  if (!v->readable)
+    return 0;
+  v->readable = 0;
+  return XPending(v->dpy) > 0;
+}
+
+/* Saves what would otherwise be lost and exits */
+void Quit(int status)
+{
+  hist_store_flush(&history);
+  if (stream_dropped())
+    fprintf(stderr,"wmsensors: %lu stream lines dropped\n", stream_dropped());
+  exit(status);
+}
+
+/* The default handler exits, which would take the other views with it */
+static XErrorHandler usual_handler;
+
+static int IgnoreBadWindow(Display *dpy, XErrorEvent *err)
+{
+  if (err->error_code == BadWindow)
+    return 0;
+  return usual_handler(dpy, err);
+}
+
+/* Closed from the window manager, which has destroyed gone already. The
+   other window may have gone with it, so a BadWindow is ignored here.
+   Sampling carries on while any view is left. */
+void CloseView(View *v, Window gone)
+{
+  usual_handler = XSetErrorHandler(IgnoreBadWindow);
+  XFreeGC(v->dpy, v->NormalGC);
+  if (v->win != gone)
+    XDestroyWindow(v->dpy, v->win);
+  if (v->iconwin != gone)
+    XDestroyWindow(v->dpy, v->iconwin);
+  XCloseDisplay(v->dpy);       /* syncs, so any errors come in here */
+  XSetErrorHandler(usual_handler);
+  v->dpy = NULL;
+  nopen--;
+}
+
+/*****************************************************************************/
+
+void InitLm(View *v)
 {
   /* Save the 14 base colors in wmsensors pixmap */
-  XCopyArea(dpy, visible.pixmap, wmsensors.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->wmsensors.pixmap, v->NormalGC,
             6,6,15,52, Shape(6), Shape(6));
 
   /* Copy the base panel to visible */
-  XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-	    0,0,mysizehints.width, mysizehints.height, 0 ,0);
+  XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
+	    0,0,v->mysizehints.width, v->mysizehints.height, 0 ,0);
 
   /* Remove the 4 base colors from visible */
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
 	    Shape(22),Shape(6),15,52, Shape(6), Shape(6));  
 
   /* Somewhat tediously put in all the initial guide lines */
-  XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(16), Shape(8), 1, 1, Shape(31), Shape(11));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(31), Shape(11), 1, 1, Shape(30), Shape(11));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(30), Shape(11), 2, 1, Shape(28), Shape(11));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(28), Shape(11), 4, 1, Shape(24), Shape(11));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(24), Shape(11), 8, 1, Shape(16), Shape(11));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(16), Shape(11), 10, 1, Shape(6), Shape(11));
 
   /* First one done! Now copy to the others... */
 
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 26, 1, Shape(6), Shape(21));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 26, 1, Shape(6), Shape(31));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 26, 1, Shape(6), Shape(42));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 26, 1, Shape(6), Shape(52));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 25, 1, Shape(33), Shape(10));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 25, 1, Shape(33), Shape(18));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 25, 1, Shape(33), Shape(26));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 25, 1, Shape(33), Shape(35));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 25, 1, Shape(33), Shape(44));
-  XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+  XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
             Shape(6), Shape(11), 25, 1, Shape(33), Shape(53));
 }
 
@@ -626,64 +874,52 @@ void InitLm()
 /* GetLimits() function */
 /************************/
 
-void GetLimits(double *temp_ll, double *temp2_ul, double *temp3_ul, double *temp1_ul, double *in0_ll, double *in0_ul, double *in1_ll, double *in1_ul, double *in2_ll, double *in2_ul, double *in3_ll, double *in3_ul, double *in4_ll, double *in4_ul, double *in5_ll, double *in5_ul, double *in6_ll, double *in6_ul)
+void GetLimits(struct limits *l)
 {
-
+  static const int feature[] = {
+    SENSORS_LM78_IN0_MIN, SENSORS_LM78_IN1_MIN, SENSORS_LM78_IN2_MIN,
+    SENSORS_LM78_IN3_MIN, SENSORS_LM78_IN4_MIN, SENSORS_LM78_IN5_MIN,
+    SENSORS_LM78_IN6_MIN,
+    SENSORS_LM78_IN0_MAX, SENSORS_LM78_IN1_MAX, SENSORS_LM78_IN2_MAX,
+    SENSORS_LM78_IN3_MAX, SENSORS_LM78_IN4_MAX, SENSORS_LM78_IN5_MAX,
+    SENSORS_LM78_IN6_MAX,
+    SENSORS_LM78_TEMP_OVER, SENSORS_W83781D_TEMP2_OVER,
+    SENSORS_W83781D_TEMP3_OVER
+  };
+  double *const dest[] = {
+    &l->lo[CH_IN0], &l->lo[CH_IN1], &l->lo[CH_IN2], &l->lo[CH_IN3],
+    &l->lo[CH_IN4], &l->hi[CH_IN5], &l->hi[CH_IN6],
+    &l->hi[CH_IN0], &l->hi[CH_IN1], &l->hi[CH_IN2], &l->hi[CH_IN3],
+    &l->hi[CH_IN4], &l->lo[CH_IN5], &l->lo[CH_IN6],
+    &l->hi[CH_TEMP1], &l->hi[CH_TEMP2], &l->hi[CH_TEMP3]
+  };
   int chip_nr;
   const sensors_chip_name *name;
 
   /* We set the default limits; these will be used if reading fails. */
-  *temp_ll = 20;
-  *temp2_ul = 60;
-  *temp3_ul = 60;
-  *temp1_ul = 60;
-  *in0_ll = 1.8;
-  *in0_ul = 2.2;
-  *in1_ll = 1.8;
-  *in1_ul = 2.2;
-  *in2_ll = 3.0;
-  *in2_ul = 3.6;
-  *in3_ll = 4.5;
-  *in3_ul = 5.5;
-  *in4_ll = 10.80;
-  *in4_ul = 13.20;
-  *in5_ll = -13.20;
-  *in5_ul = -10.80;
-  *in6_ll = -5.5;
-  *in6_ul = -4.5;
+  default_limits(l);
 
+  /* A chip that isn't answering would only hold the update up */
   for (chip_nr = 0; (name=sensors_get_detected_chips(&chip_nr));)
-  {
-    sensors_get_feature(*name,SENSORS_LM78_IN0_MIN, in0_ll);
-    sensors_get_feature(*name,SENSORS_LM78_IN1_MIN, in1_ll);
-    sensors_get_feature(*name,SENSORS_LM78_IN2_MIN, in2_ll);
-    sensors_get_feature(*name,SENSORS_LM78_IN3_MIN, in3_ll);
-    sensors_get_feature(*name,SENSORS_LM78_IN4_MIN, in4_ll);
-    sensors_get_feature(*name,SENSORS_LM78_IN5_MIN, in5_ul);
-    sensors_get_feature(*name,SENSORS_LM78_IN6_MIN, in6_ul);
-
-    sensors_get_feature(*name,SENSORS_LM78_IN0_MAX, in0_ul);
-    sensors_get_feature(*name,SENSORS_LM78_IN1_MAX, in1_ul);
-    sensors_get_feature(*name,SENSORS_LM78_IN2_MAX, in2_ul);
-    sensors_get_feature(*name,SENSORS_LM78_IN3_MAX, in3_ul);
-    sensors_get_feature(*name,SENSORS_LM78_IN4_MAX, in4_ul);
-    sensors_get_feature(*name,SENSORS_LM78_IN5_MAX, in5_ll);
-    sensors_get_feature(*name,SENSORS_LM78_IN6_MAX, in6_ll);
-
-    sensors_get_feature(*name,SENSORS_LM78_TEMP_OVER, temp1_ul);
-    sensors_get_feature(*name,SENSORS_W83781D_TEMP2_OVER, temp2_ul);
-    sensors_get_feature(*name,SENSORS_W83781D_TEMP3_OVER, temp3_ul);
-  }
+    if (!reader_chip_backed_off(name))
+      reader_get_features(name, feature, dest,
+			  sizeof(feature) / sizeof(feature[0]));
 }
 
 /********************/
 /* GetLm() function */
 /********************/
 
-void GetLm(double *temp2, double *temp3, double *temp1, double *in0, double *in1, double *in2, double *in3, double *in6, double *in4, double *in5, double *fan1, double *fan2, double *fan3, int multiple_lm75, double *alrms)
+void GetLm(double *temp2, double *temp3, double *temp1, double *in0, double *in1, double *in2, double *in3, double *in6, double *in4, double *in5, double *fan1, double *fan2, double *fan3, int multiple_lm75, double *alrms, unsigned *stale)
 { 
-  int chip_nr;
-  const sensors_chip_name *name;
+  static struct chip_reading chips[MAX_CHIPS];
+  static const int channel[NFEATURES] = {
+    CH_IN0, CH_IN1, CH_IN2, CH_IN3, CH_IN4, CH_IN5, CH_IN6, CH_TEMP1,
+    CH_FAN1, CH_FAN2, CH_FAN3, -1, CH_TEMP2, CH_TEMP3
+  };
+  double *dest[NFEATURES];
+  unsigned fresh = 0, missed = 0;
+  int nchips, i, f;
   
   *temp1 = -279;
   *temp2 = -279;
@@ -699,25 +935,198 @@ void GetLm(double *temp2, double *temp3, double *temp1, double *in0, double *in1
   *fan1 = 0;
   *fan2 = 0;
   *fan3 = 0;  
+  *alrms = 0;
+
+  dest[F_IN0] = in0;
+  dest[F_IN1] = in1;
+  dest[F_IN2] = in2;
+  dest[F_IN3] = in3;
+  dest[F_IN4] = in4;
+  dest[F_IN5] = in5;
+  dest[F_IN6] = in6;
+  dest[F_TEMP] = temp1;
+  dest[F_FAN1] = fan1;
+  dest[F_FAN2] = fan2;
+  dest[F_FAN3] = fan3;
+  dest[F_ALARMS] = alrms;
+  dest[F_TEMP2] = temp2;
+  dest[F_TEMP3] = temp3;
+
+  /* Here comes the real code... The readings are applied in detection
+     order so later chips still win. */
+
+  TRACE_BEGIN(read, 0);
+  nchips = reader_sample(chips, MAX_CHIPS);
+  TRACE_END(read, 0);
+  for (i = 0; i < nchips; i++) {
+    for (f = 0; f < NFEATURES; f++)
+      if (chips[i].got & (1 << f))
+	*dest[f] = chips[i].v[f];
+    fresh |= chips[i].got;
+    missed |= chips[i].stale;
+  }
 
-  /* Here comes the real code... */
+  /* Channels that a failing chip would have given, and no other did */
+  *stale = 0;
+  for (f = 0; f < NFEATURES; f++)
+    if ((missed & ~fresh & (1 << f)) && channel[f] >= 0)
+      *stale |= 1 << channel[f];
+}
 
-  for (chip_nr = 0; (name=sensors_get_detected_chips(&chip_nr));)
-  {
-       sensors_get_feature(*name,SENSORS_LM78_IN0, in0);
-       sensors_get_feature(*name,SENSORS_LM78_IN1, in1);
-       sensors_get_feature(*name,SENSORS_LM78_IN2, in2);
-       sensors_get_feature(*name,SENSORS_LM78_IN3, in3);
-       sensors_get_feature(*name,SENSORS_LM78_IN4, in4);
-       sensors_get_feature(*name,SENSORS_LM78_IN5, in5);
-       sensors_get_feature(*name,SENSORS_LM78_IN6, in6);
-       sensors_get_feature(*name,SENSORS_LM78_TEMP, temp1);
-       sensors_get_feature(*name,SENSORS_LM78_FAN1, fan1);
-       sensors_get_feature(*name,SENSORS_LM78_FAN2, fan2);
-       sensors_get_feature(*name,SENSORS_LM78_FAN3, fan3);
-       sensors_get_feature(*name,SENSORS_LM78_ALARMS, alrms);
-       sensors_get_feature(*name,SENSORS_W83781D_TEMP2, temp2);
-       sensors_get_feature(*name,SENSORS_W83781D_TEMP3, temp3);
+/***************************************************************************/
+
+/* An alarm attribute went on. When the driver told us (notified) we say
+   how long the periodic check would have taken to notice; otherwise the
+   periodic check is what found it. */
+void HwmonAlarm(const char *which, int notified)
+{
+  if (notified)
+    fprintf(stderr,"Alarm! %s (%ld s before the next sample)\n", which,
+	    (long)(updatespeed - time(0) % updatespeed));
+  else
+    fprintf(stderr,"Alarm! %s\n", which);
+  TRACE_BEGIN(alarm, 0);
+  command_run(&OnAlarm);
+  TRACE_END(alarm, 0);
+}
+
+/***************************************************************************/
+
+/* Writes a whole log line, waiting if the descriptor is non-blocking and
+   full. Logging stops if the log can't be written at all. */
+void LogWrite(const char *buf, int n)
+{
+  struct pollfd pfd;
+  int done;
+
+  while (n > 0) {
+    if ((done = write(fileno(log_file), buf, n)) >= 0) {
+      buf += done;
+      n -= done;
+    } else if (errno == EAGAIN) {
+      pfd.fd = fileno(log_file);
+      pfd.events = POLLOUT;
+      poll(&pfd, 1, -1);
+    } else if (errno != EINTR) {
+      fprintf(stderr,"wmsensors: can't write the log: %s\n", strerror(errno));
+      log_status = 0;
+      return;
+    }
+  }
+}
+
+/* Keeps a copy of the configuration libsensors has just loaded from f, to
+   fall back on if a reload finds the file broken */
+void KeepConfig(FILE *f)
+{
+  char buffer[4096];
+  size_t n;
+  FILE *copy;
+
+  if (!(copy = tmpfile()))
+    return;
+  rewind(f);
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    fwrite(buffer, 1, n, copy);
+  if (ferror(f) || fflush(copy)) {
+    fclose(copy);
+    return;
+  }
+  if (good_config)
+    fclose(good_config);
+  good_config = copy;
+}
+
+/* Re-reads sensors.conf, for new limits, labels or chips. The windows,
+   pixmaps and history are left alone, and we are between updates, so
+   the next update simply uses the new configuration. If the file can't
+   be opened the old configuration stays. */
+void ReloadSensors(void)
+{
+  FILE *f;
+  int res;
+
+  reload_wanted = 0;
+  if (!config_file_name || !strcmp(config_file_name, "-")) {
+    fprintf(stderr,"wmsensors: can't reload a configuration read from stdin\n");
+    return;
+  }
+  if (!(f = fopen(config_file_name, "r"))) {
+    fprintf(stderr,"wmsensors: can't reload %s: %s\n", config_file_name,
+	    strerror(errno));
+    return;
+  }
+  reader_cleanup();
+  sensors_cleanup();
+  if ((res = sensors_init(f))) {
+    /* libsensors has nothing loaded now; go back to what worked */
+    fprintf(stderr,"wmsensors: reloading %s: %s, keeping the old configuration\n",
+	    config_file_name, sensors_strerror(res));
+    sensors_cleanup();
+    if (good_config) {
+      rewind(good_config);
+      if ((res = sensors_init(good_config)))
+	fprintf(stderr,"wmsensors: can't go back to the old configuration: %s\n",
+		sensors_strerror(res));
+    }
+  } else {
+    KeepConfig(f);
+    fprintf(stderr,"wmsensors: reloaded %s\n", config_file_name);
+  }
+  fclose(f);
+  reader_init();
+  limits_wanted = 1;
+}
+
+/* Carries out a command from the control FIFO */
+void Control(int cmd, const char *arg)
+{
+  FILE *f;
+  int secs;
+
+  switch (cmd) {
+  case CTL_RELOAD:
+    reload_wanted = 1;
+    break;
+  case CTL_UPDATE:
+    if (sscanf(arg, "%d", &secs) == 1 && secs > 0)
+      updatespeed = secs;
+    else
+      fprintf(stderr,"wmsensors: bad update speed '%s'\n", arg);
+    break;
+  case CTL_ALARM:
+    AlarmStatus = *arg != '\0';
+    if (command_parse(&OnAlarm, arg)) {
+      fprintf(stderr,"wmsensors: alarm command too long\n");
+      AlarmStatus = 0;
+    }
+    if (AlarmStatus) {
+      if (!hwmon_opened) {
+	hwmon_alarms_open(HWMON_DIR);
+	hwmon_opened = 1;
+      }
+    }
+    break;
+  case CTL_LOG:
+    if (!strcmp(arg, "off"))
+      f = NULL;
+    else if (!strcmp(arg, "-"))
+      f = stdout;
+    else if (!*arg || !(f = fopen(arg, "w"))) {
+      fprintf(stderr,"wmsensors: can't write log file '%s'\n", arg);
+      break;
+    }
+    if (log_file && log_file != stdout)
+      fclose(log_file);
+    log_file = f;
+    log_status = f != NULL;
+    if (log_status) {
+      fprintf(log_file, LOG_HEADER);
+      fflush(log_file);
+    }
+    break;
+  default:
+    fprintf(stderr,"wmsensors: unknown control command\n");
   }
 }
 
@@ -726,191 +1135,151 @@ void GetLm(double *temp2, double *temp3, double *temp1, double *in0, double *in1
 void InsertLm(int multiple_lm75, int AlarmRequired)
 {
    double temp2, temp3, temp1, in0, in1, in3, in2, in6, in4, in5;
-   double temp2_ul, temp3_ul, temp1_ul, in0_ul, in1_ul, in3_ul, in2_ul;
-   double in6_ul, in4_ul, in5_ul, temp_ll;
-   double in0_ll, in1_ll, in3_ll, in2_ll, in6_ll, in4_ll, in5_ll;   
-   double fan1, fan2, fan3, act;
+   double fan1, fan2, fan3;
    double alrms;
-   int temp1p, temp2p, temp3p, in0p, in1p, in2p, in3p, in4p, in5p, in6p, fan1p, fan2p, fan3p;
-   GetLm(&temp2, &temp3, &temp1, &in0, &in1, &in2, &in3, &in6, &in4, &in5, &fan1, &fan2, &fan3, multiple_lm75, &alrms);
-   GetLimits(&temp_ll, &temp2_ul, &temp3_ul, &temp1_ul, &in0_ll, &in0_ul, &in1_ll, &in1_ul, &in2_ll, &in2_ul, &in3_ll, &in3_ul, &in4_ll, &in4_ul, &in5_ll, &in5_ul, &in6_ll, &in6_ul);
+   static struct limits lim;
+   static int limits_age;
+   struct sample s;
+   struct graph_point points[NCHANNELS];
+   char log_line[256];
+   int alarm, npoints, i, n, heading = -1;
+   unsigned stale;
+   double when, heading_when = 0;
+   GetLm(&temp2, &temp3, &temp1, &in0, &in1, &in2, &in3, &in6, &in4, &in5, &fan1, &fan2, &fan3, multiple_lm75, &alrms, &stale);
+   /* The limits only change when sensors.conf is reloaded or sensors -s is
+      run, so they aren't read again every update */
+   if (limits_wanted || ++limits_age >= LIMITS_EVERY) {
+     TRACE_BEGIN(limits, 0);
+     GetLimits(&lim);
+     TRACE_END(limits, 0);
+     limits_wanted = limits_age = 0;
+   }
    if (temp3==-279 && temp2 !=-279)
      temp3 = temp2;
+   /* Keep the raw readings in the history */
+   s.t = time(0);
+   s.v[CH_TEMP1] = temp1; s.v[CH_TEMP2] = temp2; s.v[CH_TEMP3] = temp3;
+   s.v[CH_IN0] = in0; s.v[CH_IN1] = in1; s.v[CH_IN2] = in2;
+   s.v[CH_IN3] = in3; s.v[CH_IN4] = in4; s.v[CH_IN5] = in5;
+   s.v[CH_IN6] = in6;
+   s.v[CH_FAN1] = fan1; s.v[CH_FAN2] = fan2; s.v[CH_FAN3] = fan3;
+   hist_store_append(&history, &s);
    /* Before we transform the data, write it to the log file if requested */
    if (log_status) {
-     if ((temp1==-279 || temp2==-279 || in3==-279 || in6==-279 || in4==-279
+     TRACE_BEGIN(log, 0);
+     if (stale)
+       strcpy(log_line, "# Stale ");
+     else if ((temp1==-279 || temp2==-279 || in3==-279 || in6==-279 || in4==-279
            || in5==-279 || in0==-279 || in1==-279 || in2==-279) && count_printings)
-       fprintf(log_file, "# Error ");
-     fprintf(log_file, "%2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f %2.2f\n",
-             temp1, temp2, temp3, in0, in1, in2, in3, in4, in5, in6, fan1,
-             fan2, fan3);
-     fflush(log_file);
+       strcpy(log_line, "# Error ");
+     else
+       log_line[0] = '\0';
+     /* One write, straight to the file */
+     n = strlen(log_line);
+     n += format_log_line(log_line + n, sizeof(log_line) - n, &s);
+     if (n >= (int)sizeof(log_line)) {
+       /* Cut short, but still one line */
+       n = sizeof(log_line) - 1;
+       log_line[n - 1] = '\n';
+     }
+     LogWrite(log_line, n);
+     TRACE_END(log, 0);
    }
 
    /* Sort out whether the alarms need triggering */
-   if (((alrms || ((temp1 > temp1_ul) || (temp2 > temp2_ul) || (temp3 > temp3_ul))) && temp1 > -279 && temp2 > -279 && temp3 > -279) && AlarmRequired)
+   alarm = (alrms || ((temp1 > lim.hi[CH_TEMP1]) || (temp2 > lim.hi[CH_TEMP2]) || (temp3 > lim.hi[CH_TEMP3]))) && temp1 > -279 && temp2 > -279 && temp3 > -279;
+
+   /* Follow each channel's trend, and find the first one that is still
+      within its limits but heading out of them soon */
+   for (i = 0; i < NCHANNELS; i++) {
+     trend_update(&trends[i], s.t, s.v[i]);
+     if (predict_horizon > 0 && heading < 0 && s.v[i] != NO_READING
+	 && s.v[i] >= lim.lo[i] && s.v[i] <= lim.hi[i]
+	 && (when = trend_crossing(&trends[i], lim.lo[i], lim.hi[i],
+				   predict_horizon)) >= 0) {
+       heading = i;
+       heading_when = when;
+     }
+   }
+
+   stream_push(&s, alarm);
+   if (alarm && AlarmRequired)
      {
        if (alrms > 0.5)
 	 fprintf(stderr,"Alarm! Alarm on IN%.0f\n",alrms-2);
        else
 	 fprintf(stderr,"Alarm! Temperature 1: %.2f  Temperature 2: %.2f  Temperature 3: %.2f\n",temp1, temp2, temp3);
-       system(ExecuteAlarm);
+       TRACE_BEGIN(alarm, 0);
+       command_run(&OnAlarm);
+       TRACE_END(alarm, 0);
+     }
+   else if (heading >= 0 && AlarmRequired)
+     {
+       fprintf(stderr,"Alarm! %s is %.2f and heading past %.2f in %.0f s\n",
+	       channel_names[heading], s.v[heading],
+	       trend_limit(&trends[heading], lim.lo[heading], lim.hi[heading]),
+	       heading_when);
+       TRACE_BEGIN(alarm, 0);
+       command_run(&OnAlarm);
+       TRACE_END(alarm, 0);
      }
 
    /* Convert data into actual pixel values */
-   /* Temperatures (for left-hand column) */
-/*   fprintf(log_file, "# Pixel conversion.\n"); */
-   temp2p=((temp2-temp_ll)/3)+42;
-   temp3p=((temp3-temp_ll)/3)+42;
-   temp1p=((temp1-temp_ll)/3)+42;
-   /* Safety checks on temperature levels */
-   if (temp1p > 52) temp1p = 51;
-   if (temp2p > 52) temp2p = 51;
-   if (temp3p > 52) temp3p = 51;
-
-   /* Left hand column */
-   in3p=32+(((in3-in3_ll)/(in3_ul-in3_ll))*(43-32));
-   in6p=23+(((in6-in6_ll)/(in6_ul-in6_ll))*(32-23));
-   in4p=11+(((in4-in4_ll)/(in4_ul-in4_ll))*(22-11));
-   in5p= 1+(((in5-in5_ll)/(in5_ul-in5_ll))*(22-12));
-
-   /* Right hand column */
-   in0p=44+(((in0-in0_ll)/(in0_ul-in0_ll))*(53-44));
-   in1p=37+(((in1-in1_ll)/(in1_ul-in1_ll))*(44-36));
-   in2p=29+(((in2-in2_ll)/(in2_ul-in2_ll))*(36-29));
-
-   fan1p=(fan1/625)+19;
-   fan2p=(fan2/625)+10;
-   fan3p=(fan3/625)+1;
+   TRACE_BEGIN(convert, 0);
+   /* A stale channel carries on at its last good reading, in grey */
+   for (i = 0; i < NCHANNELS; i++)
+     if (!(stale & (1 << i)))
+       shown.v[i] = s.v[i];
+   npoints = graph_points(&shown, &lim, multiple_lm75, points);
+   for (i = 0; i < npoints; i++)
+     if (stale & (1 << points[i].channel))
+       points[i].colour = GRAPH_STALE_COLOUR;
+   TRACE_END(convert, 0);
 
 /*   fprintf(log_file, "# Window redraw.\n");   */
+   TRACE_BEGIN(draw, 0);
+   for (i = 0; i < nviews; i++)
+     if (views[i].dpy)
+       DrawLm(&views[i], points, npoints);
+    TRACE_END(draw, 0);
+    count_printings++;
+}
+
+/* Scrolls one view's graphs along and plots the new points on those
+   channels its layout shows */
+void DrawLm(View *v, const struct graph_point *points, int npoints)
+{
+  int i;
+
    /* Move the areas (ie shift the pre-drawn rectangles left) */
-   XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+   XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
         	Shape(7), Shape(6), 25, 52, Shape(6), Shape(6));
-    XCopyArea(dpy, visible.pixmap, visible.pixmap, NormalGC,
+    XCopyArea(v->dpy, v->visible.pixmap, v->visible.pixmap, v->NormalGC,
                 Shape(33), Shape(6), 25, 52, Shape(32), Shape(6));
 
     /* Blacks out the right-hand columns so we don't get old data copied
 left */
-    XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(20), Shape(6), 1, 57, Shape(57), Shape(6));
-    XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(20), Shape(6), 1, 57, Shape(31), Shape(6));
+    XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
+              Shape(GRAPH_BLANK_COLOUR), Shape(6), 1, 57, Shape(GRAPH_RIGHT), Shape(6));
+    XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
+              Shape(GRAPH_BLANK_COLOUR), Shape(6), 1, 57, Shape(GRAPH_LEFT), Shape(6));
 
     /* Draws the dividing line down the middle of the display */
-    XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-	      Shape(8), Shape(6), 1, 57, Shape(32), Shape(6));
+    XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
+	      Shape(GRAPH_DIVIDER_COLOUR), Shape(6), 1, 57, Shape(GRAPH_DIVIDER), Shape(6));
 
     /* Draws the grey lines where the normal values of the parameters lie */
-    XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(31), Shape(11));
-    XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(31), Shape(21));
-     XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(31), Shape(31));
-     XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(31), Shape(42));
-     XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(31), Shape(52));
-    XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(57), Shape(10));
-    XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(57), Shape(18));
-     XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(57), Shape(26));
-     XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(57), Shape(35));
-     XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(16), Shape(8), 1, 1, Shape(57), Shape(44));
-     XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-	      Shape(16), Shape(8), 1, 1, Shape(57), Shape(53));
+    for (i = 0; i < NGUIDES_LEFT; i++)
+      XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
+                Shape(GRAPH_GUIDE_COLOUR), Shape(8), 1, 1, Shape(GRAPH_LEFT), Shape(graph_guides_left[i]));
+    for (i = 0; i < NGUIDES_RIGHT; i++)
+      XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
+                Shape(GRAPH_GUIDE_COLOUR), Shape(8), 1, 1, Shape(GRAPH_RIGHT), Shape(graph_guides_right[i]));
 
 /*     fprintf(log_file, "# Redrawing graphs.\n"); */
-    /* CPU temps and motherboard temp */
-    act = 58 - temp2p;
-    if( temp2 > -100)
-      /* Height 1 rectangle */
-       XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-	      Shape(6), Shape(6), 1, 1, Shape(31), Shape(act));
-
-    if (multiple_lm75)
-    {
-      act = 58 - temp3p;
-      if ( temp3 > -100)
-        XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-               Shape(6), Shape(6), 1, 1, Shape(31), Shape(act));
-    }
-
-    act = 58 - temp1p;
-    if( temp1 > -100)
-       XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-              Shape(6), Shape(6), 1, 1, Shape(31), Shape(act));
-
-    /* in0 */
-    act = 58 - in0p;
-    if( in0 > -100)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-		Shape(17), Shape(6), 1, 1, Shape(57), Shape(act));
-
-    /* in1 */
-    act = 58 - in1p;
-    if( in1 > -100)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-		Shape(18), Shape(6), 1, 1, Shape(57), Shape(act));
-
-    /* in2 */
-    act = 58 - in2p;
-    if( in2 > -100)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-		Shape(15), Shape(6), 1, 1, Shape(57), Shape(act));
-
-    /* in3 */
-    act = 58 - in3p;
-    if( in3 > -100)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-		Shape(9), Shape(6), 1, 1, Shape(31), Shape(act)); 
-
-    /* in6 */
-    act = 58 - in6p;
-    if (in6 > -100)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-		Shape(10), Shape(6), 1, 1, Shape(31), Shape(act));
-
-    /* in4 */
-    act = 58 - in4p;
-    if (in4 > -100)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-                Shape(11), Shape(6), 1, 1, Shape(31), Shape(act));
-
-    /* in5 */
-    act = 58 - in5p;
-    if (in5 > -100)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-                Shape(12), Shape(6), 1, 1, Shape(31), Shape(act));
- 
-    /* fan1 */
-    act = 58 - fan1p;
-    if (fan1p > 20)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-                Shape(13), Shape(6), 1, 1, Shape(57), Shape(act));
-    /* fan2 */
-    act = 58 - fan2p;
-    if (fan2p > 11)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-                Shape(14), Shape(6), 1, 1, Shape(57), Shape(act));
-    /* fan3 */
-    act = 58 - fan3p;
-    if (fan3p > 1)
-      XCopyArea(dpy, wmsensors.pixmap, visible.pixmap, NormalGC,
-                Shape(19), Shape(6), 1, 1, Shape(57), Shape(act));
-    count_printings++;
+    /* Height 1 rectangles in each graph's colour */
+    for (i = 0; i < npoints; i++)
+      if (v->channels & (1 << points[i].channel))
+	XCopyArea(v->dpy, v->wmsensors.pixmap, v->visible.pixmap, v->NormalGC,
+		  Shape(points[i].colour), Shape(GRAPH_COLOUR_ROW), 1, 1, Shape(points[i].x), Shape(points[i].y));
 }
-
-
-
-
-
-
-
-
-
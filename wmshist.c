@@ -0,0 +1,224 @@
+/*
+    wmshist.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Converts between the -r text log and the compressed -z history (writing
+   its index too), and measures how the two compare. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "sample.h"
+#include "history.h"
+
+char *ProgName;
+int interval = 4;
+
+void usage()
+{
+  fprintf(stderr,"\nusage:  %s [-i <secs>] [-b] <logfile> <histfile>\n", ProgName);
+  fprintf(stderr,"        %s -d <histfile>\n", ProgName);
+  fprintf(stderr,"    -i <secs>               sample interval of an untimed log (default 4)\n");
+  fprintf(stderr,"    -b                      report size and speed against the log\n");
+  fprintf(stderr,"    -d                      write a history file out as a log\n\n");
+  exit(1);
+}
+
+double now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*****************************************************************************/
+/* Reads a whole log file into memory. Returns the number of samples and
+   the size of the file in *bytes. */
+int load_log(const char *filename, struct sample **out, long *bytes)
+{
+  FILE *f;
+  char line[512];
+  struct sample *s = NULL;
+  int n = 0, max = 0;
+
+  if (!strcmp(filename, "-"))
+    f = stdin;
+  else if (!(f = fopen(filename, "r"))) {
+    perror(filename);
+    exit(1);
+  }
+  *bytes = 0;
+  while (fgets(line, sizeof(line), f)) {
+    *bytes += strlen(line);
+    if (n == max) {
+      max = max ? max * 2 : 1024;
+      if (!(s = realloc(s, max * sizeof(*s)))) {
+	fprintf(stderr, "%s: out of memory\n", ProgName);
+	exit(1);
+      }
+    }
+    switch (parse_log_line(line, &s[n])) {
+    case 1:
+      s[n].t = (time_t)n * interval;
+      /* fall through */
+    case 2:
+      n++;
+    }
+  }
+  if (f != stdin)
+    fclose(f);
+  *out = s;
+  return n;
+}
+
+/*****************************************************************************/
+void pack(const char *logname, const char *histname, int bench)
+{
+  struct sample *s, t;
+  struct hist_block b;
+  struct hist_reader r;
+  FILE *f, *idx;
+  char line[512];
+  long text_bytes, hist_bytes = HIST_FILE_MAGIC_LEN, blocks = 0;
+  double start, parse_s, format_s, encode_s, decode_s;
+  int n, i;
+
+  start = now();
+  n = load_log(logname, &s, &text_bytes);
+  parse_s = now() - start;
+
+  if (!(f = fopen(histname, "wb")) || hist_file_write_header(f)
+      || !(idx = hist_index_open(histname, "wb"))
+      || hist_index_write_header(idx)) {
+    perror(histname);
+    exit(1);
+  }
+  start = now();
+  hist_block_init(&b);
+  for (i = 0; i <= n; i++)
+    if (i == n || hist_block_append(&b, &s[i])) {
+      if (!b.n)
+	break;
+      hist_block_write(f, &b);
+      hist_index_append(idx, &b, hist_bytes);
+      hist_bytes += HIST_BLOCK_HEADER_LEN + hist_block_bytes(&b);
+      blocks++;
+      hist_block_init(&b);
+      if (i < n)
+	hist_block_append(&b, &s[i]);
+    }
+  encode_s = now() - start;
+  fclose(f);
+  fclose(idx);
+
+  if (!bench || !n)
+    return;
+
+  start = now();
+  for (i = 0; i < n; i++)
+    format_log_line(line, sizeof(line), &s[i]);
+  format_s = now() - start;
+
+  if (!(f = fopen(histname, "rb")) || hist_file_check_header(f)) {
+    perror(histname);
+    exit(1);
+  }
+  start = now();
+  while (hist_block_read(f, &b) == 0) {
+    hist_reader_init(&r, &b);
+    while (hist_reader_next(&r, &t) > 0)
+      ;
+  }
+  decode_s = now() - start;
+  fclose(f);
+
+  printf("%d samples in %ld blocks\n", n, blocks);
+  printf("text log:  %10ld bytes  %6.2f bytes/sample\n",
+	 text_bytes, (double)text_bytes / n);
+  printf("history:   %10ld bytes  %6.2f bytes/sample  (%.1fx smaller)\n",
+	 hist_bytes, (double)hist_bytes / n, (double)text_bytes / hist_bytes);
+  printf("text parse:  %12.0f samples/s\n", n / (parse_s > 0 ? parse_s : 1e-9));
+  printf("text format: %12.0f samples/s\n", n / (format_s > 0 ? format_s : 1e-9));
+  printf("encode:      %12.0f samples/s\n", n / (encode_s > 0 ? encode_s : 1e-9));
+  printf("decode:      %12.0f samples/s\n", n / (decode_s > 0 ? decode_s : 1e-9));
+}
+
+/*****************************************************************************/
+void unpack(const char *histname)
+{
+  struct hist_block b;
+  struct hist_reader r;
+  struct sample s;
+  FILE *f;
+  char line[512];
+  int res;
+
+  if (!(f = fopen(histname, "rb"))) {
+    perror(histname);
+    exit(1);
+  }
+  if (hist_file_check_header(f)) {
+    fprintf(stderr, "%s: not a wmsensors history file\n", histname);
+    exit(1);
+  }
+  fputs(LOG_HEADER, stdout);
+  while ((res = hist_block_read(f, &b)) == 0) {
+    hist_reader_init(&r, &b);
+    while ((res = hist_reader_next(&r, &s)) > 0) {
+      format_log_line(line, sizeof(line), &s);
+      fputs(line, stdout);
+    }
+    if (res < 0)
+      break;
+  }
+  if (res < 0)
+    fprintf(stderr, "%s: truncated or damaged history file\n", histname);
+  fclose(f);
+}
+
+int main(int argc, char *argv[])
+{
+  int i, bench = 0, decode = 0;
+
+  ProgName = argv[0];
+  for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+    switch (argv[i][1]) {
+    case 'i':
+      if (++i >= argc) usage();
+      interval = atoi(argv[i]);
+      break;
+    case 'b':
+      bench = 1;
+      break;
+    case 'd':
+      decode = 1;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (decode && argc - i == 1)
+    unpack(argv[i]);
+  else if (!decode && argc - i == 2)
+    pack(argv[i], argv[i + 1], bench);
+  else
+    usage();
+  return 0;
+}
@@ -0,0 +1,214 @@
+/*
+    wmsquery.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Answers time range and threshold queries against a -z history file.
+   The index is binary searched for the first block of the range, and any
+   block whose minimum and maximum rule it out is never read. */
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 500    /* for strptime */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include "sample.h"
+#include "history.h"
+
+char *ProgName;
+
+void usage()
+{
+  fprintf(stderr,"\nusage:  %s [-options ...] <histfile>\n", ProgName);
+  fprintf(stderr,"where options include:\n");
+  fprintf(stderr,"    -f <time>               from time (seconds or YYYY-MM-DD [HH:MM[:SS]])\n");
+  fprintf(stderr,"    -t <time>               to time\n");
+  fprintf(stderr,"    -c <channel>            channel for -a and -b, eg. temp1\n");
+  fprintf(stderr,"    -a <value>              only readings above value\n");
+  fprintf(stderr,"    -b <value>              only readings below value\n");
+  fprintf(stderr,"    -s                      report blocks read and skipped\n");
+  fprintf(stderr,"    -x                      rebuild the index and quit\n\n");
+  exit(1);
+}
+
+/* Accepts seconds since the epoch or a local date and time */
+time_t parse_time(const char *arg)
+{
+  static const char *formats[] = {
+    "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d", NULL
+  };
+  struct tm tm;
+  const char *end;
+  char *e;
+  long secs;
+  int i;
+
+  secs = strtol(arg, &e, 10);
+  if (*arg && !*e)
+    return secs;
+  for (i = 0; formats[i]; i++) {
+    memset(&tm, 0, sizeof(tm));
+    if ((end = strptime(arg, formats[i], &tm)) && !*end) {
+      tm.tm_isdst = -1;
+      return mktime(&tm);
+    }
+  }
+  fprintf(stderr, "%s: can't understand time %s\n", ProgName, arg);
+  exit(1);
+}
+
+double now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int rebuild(const char *histname)
+{
+  FILE *hist, *idx;
+
+  if (!(hist = fopen(histname, "rb"))) {
+    perror(histname);
+    return 1;
+  }
+  if (!(idx = hist_index_open(histname, "wb"))
+      || hist_index_write_header(idx)
+      || hist_index_rebuild(hist, idx)) {
+    fprintf(stderr, "%s: unable to rebuild index\n", histname);
+    return 1;
+  }
+  fclose(idx);
+  fclose(hist);
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  time_t from = 0, to = LONG_MAX;
+  double above = 0, below = 0, start;
+  int has_above = 0, has_below = 0, stats = 0, channel = -1, i, res;
+  long count, e, blocks_read = 0, blocks_skipped = 0, matches = 0;
+  struct hist_index_entry ent;
+  struct hist_block *b;
+  struct hist_reader r;
+  struct sample s;
+  char line[256];
+  FILE *hist, *idx;
+
+  ProgName = argv[0];
+  for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+    switch (argv[i][1]) {
+    case 'f':
+      if (++i >= argc) usage();
+      from = parse_time(argv[i]);
+      break;
+    case 't':
+      if (++i >= argc) usage();
+      to = parse_time(argv[i]);
+      break;
+    case 'c':
+      if (++i >= argc) usage();
+      if ((channel = channel_lookup(argv[i])) < 0) {
+	fprintf(stderr, "%s: no such channel %s\n", ProgName, argv[i]);
+	exit(1);
+      }
+      break;
+    case 'a':
+      if (++i >= argc) usage();
+      above = atof(argv[i]);
+      has_above = 1;
+      break;
+    case 'b':
+      if (++i >= argc) usage();
+      below = atof(argv[i]);
+      has_below = 1;
+      break;
+    case 's':
+      stats = 1;
+      break;
+    case 'x':
+      if (i + 2 != argc) usage();
+      return rebuild(argv[i + 1]);
+    default:
+      usage();
+    }
+  }
+  if (i + 1 != argc || ((has_above || has_below) && channel < 0))
+    usage();
+
+  if (!(hist = fopen(argv[i], "rb")) || hist_file_check_header(hist)) {
+    fprintf(stderr, "%s: not a wmsensors history file\n", argv[i]);
+    exit(1);
+  }
+  if (!(idx = hist_index_open(argv[i], "rb"))) {
+    fprintf(stderr, "%s: no index, try %s -x %s\n", argv[i], ProgName,
+	    argv[i]);
+    exit(1);
+  }
+  if (!(b = malloc(sizeof(*b)))) {
+    fprintf(stderr, "%s: out of memory\n", ProgName);
+    exit(1);
+  }
+
+  start = now();
+  fputs(LOG_HEADER, stdout);
+  count = hist_index_count(idx);
+  for (e = hist_index_find(idx, count, from); e < count; e++) {
+    if (hist_index_read(idx, e, &ent) || ent.t0 > to)
+      break;
+    if ((has_above && ent.max[channel] <= above)
+	|| (has_below && ent.min[channel] >= below)) {
+      blocks_skipped++;
+      continue;
+    }
+    if (fseek(hist, ent.offset, SEEK_SET) || hist_block_read(hist, b)) {
+      fprintf(stderr, "%s: index doesn't match history, try %s -x %s\n",
+	      argv[i], ProgName, argv[i]);
+      exit(1);
+    }
+    blocks_read++;
+    hist_reader_init(&r, b);
+    while ((res = hist_reader_next(&r, &s)) > 0) {
+      if (s.t < from || s.t > to)
+	continue;
+      if (channel >= 0 && s.v[channel] == NO_READING
+	  && (has_above || has_below))
+	continue;
+      if ((has_above && !(s.v[channel] > above))
+	  || (has_below && !(s.v[channel] < below)))
+	continue;
+      format_log_line(line, sizeof(line), &s);
+      fputs(line, stdout);
+      matches++;
+    }
+    if (res < 0)
+      fprintf(stderr, "%s: damaged block, skipping the rest of it\n", argv[i]);
+  }
+  if (stats)
+    fprintf(stderr, "%ld matches, %ld of %ld blocks read, %ld skipped, %.3f ms\n",
+	    matches, blocks_read, count, blocks_skipped, (now() - start) * 1000);
+  fclose(idx);
+  fclose(hist);
+  return 0;
+}
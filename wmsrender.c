@@ -0,0 +1,305 @@
+/*
+    wmsrender.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Draws the wmsensors graphs for a whole -r log or -z history into an
+   XPM, without an X server. Each sample is one column, mapped and
+   coloured exactly as on screen; the left hand graphs are on top and the
+   right hand ones underneath. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "sample.h"
+#include "history.h"
+#include "graph.h"
+
+#include "back.xpm"
+
+#define PANEL_HEIGHT (GRAPH_BOTTOM - GRAPH_TOP + 1)
+#define HEIGHT (2 * PANEL_HEIGHT + 1)
+
+char *ProgName;
+int multiple_lm75 = 0;
+struct limits lim;
+
+/* The image, a column at a time. With -w it is a ring of the last width
+   columns, otherwise it grows. */
+char *columns;
+long ncolumns, first, cap;
+int fixed;
+
+char colour_char[64];          /* back.xpm character at each x of row 6 */
+
+void usage()
+{
+  fprintf(stderr,"\nusage:  %s [-options ...] <logfile|histfile>\n", ProgName);
+  fprintf(stderr,"where options include:\n");
+  fprintf(stderr,"    -w <width>              draw only the last width samples\n");
+  fprintf(stderr,"    -o <filename>           write the XPM to filename, not stdout\n");
+  fprintf(stderr,"    -l                      draw multiple LM75 temperatures\n");
+  fprintf(stderr,"    -b                      report how long each stage took\n\n");
+  exit(1);
+}
+
+double now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*****************************************************************************/
+/* Returns the back.xpm pixel row y */
+const char *xpm_row(int y)
+{
+  int w, h, ncolors, cpp;
+
+  sscanf(back_xpm[0], "%d %d %d %d", &w, &h, &ncolors, &cpp);
+  return back_xpm[1 + ncolors + y];
+}
+
+char *new_column(void)
+{
+  if (ncolumns == cap) {
+    if (fixed) {
+      first = (first + 1) % cap;
+      ncolumns--;
+    } else {
+      cap = cap ? cap * 2 : 4096;
+      if (!(columns = realloc(columns, cap * HEIGHT))) {
+	fprintf(stderr, "%s: out of memory\n", ProgName);
+	exit(1);
+      }
+    }
+  }
+  return columns + ((first + ncolumns++) % cap) * HEIGHT;
+}
+
+/* Draws one sample the way InsertLm() does: blank, divider, guides and
+   then the points */
+void draw(const struct sample *s)
+{
+  struct graph_point p[NCHANNELS];
+  char *col = new_column();
+  int i, n, y;
+
+  memset(col, colour_char[GRAPH_BLANK_COLOUR], HEIGHT);
+  col[PANEL_HEIGHT] = colour_char[GRAPH_DIVIDER_COLOUR];
+  for (i = 0; i < NGUIDES_LEFT; i++)
+    col[graph_guides_left[i] - GRAPH_TOP] = colour_char[GRAPH_GUIDE_COLOUR];
+  for (i = 0; i < NGUIDES_RIGHT; i++)
+    col[PANEL_HEIGHT + 1 + graph_guides_right[i] - GRAPH_TOP] =
+      colour_char[GRAPH_GUIDE_COLOUR];
+  n = graph_points(s, &lim, multiple_lm75, p);
+  for (i = 0; i < n; i++) {
+    /* Anything outside the graph area doesn't survive the next shift */
+    if (p[i].y < GRAPH_TOP || p[i].y > GRAPH_BOTTOM)
+      continue;
+    y = p[i].y - GRAPH_TOP;
+    if (p[i].x == GRAPH_RIGHT)
+      y += PANEL_HEIGHT + 1;
+    col[y] = colour_char[p[i].colour];
+  }
+}
+
+/*****************************************************************************/
+/* fgets(), except that the *npre bytes at pre, read from f before, come
+   first */
+char *get_line(char *buf, int size, FILE *f, char *pre, int *npre)
+{
+  int i = 0;
+
+  while (*npre && i < size - 1) {
+    buf[i] = *pre;
+    memmove(pre, pre + 1, --*npre);
+    if (buf[i++] == '\n')
+      break;
+  }
+  buf[i] = '\0';
+  if (i && (buf[i - 1] == '\n' || i == size - 1))
+    return buf;
+  if (!fgets(buf + i, size - i, f))
+    return i ? buf : NULL;
+  return buf;
+}
+
+long read_input(const char *filename)
+{
+  struct hist_block *b;
+  struct hist_reader r;
+  struct sample s;
+  char line[512], magic[HIST_FILE_MAGIC_LEN];
+  long n = 0;
+  int nmagic, res;
+  FILE *f;
+
+  if (!strcmp(filename, "-"))
+    f = stdin;
+  else if (!(f = fopen(filename, "rb"))) {
+    perror(filename);
+    exit(1);
+  }
+  /* Look for the history header by hand, as stdin can't be rewound */
+  nmagic = fread(magic, 1, HIST_FILE_MAGIC_LEN, f);
+  if (nmagic == HIST_FILE_MAGIC_LEN
+      && !memcmp(magic, HIST_FILE_MAGIC, HIST_FILE_MAGIC_LEN)) {
+    if (!(b = malloc(sizeof(*b)))) {
+      fprintf(stderr, "%s: out of memory\n", ProgName);
+      exit(1);
+    }
+    while (hist_block_read(f, b) == 0) {
+      hist_reader_init(&r, b);
+      while ((res = hist_reader_next(&r, &s)) > 0) {
+	draw(&s);
+	n++;
+      }
+      if (res < 0)
+	fprintf(stderr, "%s: damaged block, skipping the rest of it\n", filename);
+    }
+    free(b);
+  } else {
+    /* A text log, which starts with what was read looking for the header */
+    while (get_line(line, sizeof(line), f, magic, &nmagic))
+      if (parse_log_line(line, &s)) {
+	draw(&s);
+	n++;
+      }
+  }
+  if (f != stdin)
+    fclose(f);
+  return n;
+}
+
+/* Writes the colours used, then the image a row at a time */
+void write_xpm(FILE *out)
+{
+  char used[256], *row;
+  const char *cl;
+  int y, c, ncolours = 0, ncolors, w, h, cpp;
+  long x;
+
+  memset(used, 0, sizeof(used));
+  used[(unsigned char)colour_char[GRAPH_BLANK_COLOUR]] = 1;
+  used[(unsigned char)colour_char[GRAPH_DIVIDER_COLOUR]] = 1;
+  used[(unsigned char)colour_char[GRAPH_GUIDE_COLOUR]] = 1;
+  for (x = GRAPH_TOP; x < GRAPH_BLANK_COLOUR; x++)
+    used[(unsigned char)colour_char[x]] = 1;
+  for (c = 0; c < 256; c++)
+    ncolours += used[c];
+
+  fprintf(out, "/* XPM */\nstatic char *wmsensors_graph[] = {\n");
+  fprintf(out, "\"%ld %d %d 1\",\n", ncolumns, HEIGHT, ncolours);
+  sscanf(back_xpm[0], "%d %d %d %d", &w, &h, &ncolors, &cpp);
+  for (c = 1; c <= ncolors; c++) {
+    cl = back_xpm[c];
+    if (used[(unsigned char)cl[0]]) {
+      /* back.xpm has "V x" for "V c"; GetXPM() overrides it anyway */
+      fprintf(out, "\"%c c%s\",\n", cl[0], strchr(cl, '#') - 1);
+      used[(unsigned char)cl[0]] = 0;
+    }
+  }
+
+  if (!(row = malloc(ncolumns + 5))) {
+    fprintf(stderr, "%s: out of memory\n", ProgName);
+    exit(1);
+  }
+  for (y = 0; y < HEIGHT; y++) {
+    row[0] = '"';
+    for (x = 0; x < ncolumns; x++)
+      row[x + 1] = columns[((first + x) % cap) * HEIGHT + y];
+    strcpy(row + ncolumns + 1, y < HEIGHT - 1 ? "\",\n" : "\"\n");
+    fputs(row, out);
+  }
+  fprintf(out, "};\n");
+  free(row);
+}
+
+int main(int argc, char *argv[])
+{
+  char *outname = NULL;
+  const char *row;
+  double start, read_s, write_s;
+  int i, bench = 0;
+  long n;
+  FILE *out = stdout;
+
+  ProgName = argv[0];
+  for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+    switch (argv[i][1]) {
+    case 'w':
+      if (++i >= argc || (cap = atol(argv[i])) < 1) usage();
+      fixed = 1;
+      break;
+    case 'o':
+      if (++i >= argc) usage();
+      outname = argv[i];
+      break;
+    case 'l':
+      multiple_lm75 = 1;
+      break;
+    case 'b':
+      bench = 1;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (i + 1 != argc)
+    usage();
+
+  /* The same colours as on screen */
+  for (n = 0; n < NGRAPH_COLOURS; n++)
+    back_xpm[GRAPH_COLOURS_AT + n] = (char *)graph_colours[n];
+  row = xpm_row(GRAPH_COLOUR_ROW);
+  for (n = 0; n < 64 && row[n]; n++)
+    colour_char[n] = row[n];
+  /* There is no libsensors here, so the graphs use the default limits */
+  default_limits(&lim);
+
+  if (fixed && !(columns = malloc(cap * HEIGHT))) {
+    fprintf(stderr, "%s: out of memory\n", ProgName);
+    exit(1);
+  }
+
+  start = now();
+  n = read_input(argv[i]);
+  read_s = now() - start;
+  if (!ncolumns) {
+    fprintf(stderr, "%s: no samples in %s\n", ProgName, argv[i]);
+    exit(1);
+  }
+
+  if (outname && !(out = fopen(outname, "w"))) {
+    perror(outname);
+    exit(1);
+  }
+  start = now();
+  write_xpm(out);
+  if (out != stdout)
+    fclose(out);
+  write_s = now() - start;
+
+  if (bench)
+    fprintf(stderr, "%ld samples: read and drawn in %.2f s (%.0f samples/s), "
+	    "%ldx%d XPM written in %.2f s\n", n, read_s,
+	    n / (read_s > 0 ? read_s : 1e-9), ncolumns, HEIGHT, write_s);
+  return 0;
+}
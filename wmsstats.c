@@ -0,0 +1,737 @@
+/*
+    wmsstats.c - Part of wmsensors, a Linux utility for monitoring sensors.
+    Copyright (c) 1998,1999  Adrian Baugh <adrian.baugh@keble.ox.ac.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/* Summarises any number of -r logs and -z histories: for each channel the
+   number of readings, minimum, mean, maximum, percentiles and how many
+   readings were outside the limits. The readings are loaded a column per
+   channel, and the files (or pieces of large logs) and then the columns
+   are shared out between threads. With -H the predictive alarm is
+   replayed over them and scored against what actually happened. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "sample.h"
+#include "history.h"
+#include "predict.h"
+
+#define MAX_THREADS 64
+#define MAX_PERCENTILES 8
+#define CHUNK_BYTES (8L << 20)   /* text logs are read in pieces this big */
+
+/* A file, or part of a log, and the columns read from it */
+struct piece {
+  const char *filename;
+  long start, end;             /* bytes of a log to read; end -1 for all */
+  int history;
+  long n, max;
+  time_t *t;
+  double *v[NCHANNELS];
+};
+
+/* What a kernel works out over one column */
+struct partial {
+  double min, max, sum;
+  long n, below, above;
+};
+
+typedef void (*kernel_fn)(const double *v, long n, double lo, double hi,
+			  struct partial *p);
+
+char *ProgName;
+int nthreads;
+struct limits lim;
+
+struct piece *pieces;
+int npieces;
+char stdin_magic[HIST_FILE_MAGIC_LEN];  /* read from stdin by plan_pieces() */
+int stdin_nmagic;
+struct partial *partials;     /* npieces * NCHANNELS */
+struct partial totals[NCHANNELS];
+kernel_fn kernel;
+
+double percentiles[MAX_PERCENTILES] = { 50, 90, 99 };
+int npercentiles = 3;
+double results[NCHANNELS][MAX_PERCENTILES];
+
+/* How the predictive alarm did on one channel */
+struct replay {
+  long crossings;              /* times the limits were crossed */
+  long predicted;              /* of which the alarm was already on */
+  long false_alarms;           /* alarms that went off again uncrossed */
+  double lead;                 /* total warning given, in seconds */
+  double seconds;              /* time spent replaying */
+};
+
+double horizon;
+struct replay replays[NCHANNELS];
+
+void usage()
+{
+  fprintf(stderr,"\nusage:  %s [-options ...] <logfile|histfile> ...\n", ProgName);
+  fprintf(stderr,"where options include:\n");
+  fprintf(stderr,"    -p <list>               percentiles to report (default 50,90,99)\n");
+  fprintf(stderr,"    -l <channel>:<lo>:<hi>  count readings outside lo and hi\n");
+  fprintf(stderr,"    -H <secs>               score the predictive alarm with this horizon\n");
+  fprintf(stderr,"    -t <threads>            number of threads (default one per CPU)\n");
+  fprintf(stderr,"    -s                      use the plain scalar kernel\n");
+  fprintf(stderr,"    -b                      compare the speed of the kernels\n\n");
+  exit(1);
+}
+
+double now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void *xrealloc(void *p, size_t size)
+{
+  if (!(p = realloc(p, size))) {
+    fprintf(stderr, "%s: out of memory\n", ProgName);
+    exit(1);
+  }
+  return p;
+}
+
+/*****************************************************************************/
+/* Runs job(0) .. job(n - 1) on up to nthreads threads, this one included */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int next_job, njobs;
+static void (*job)(int);
+
+static void *worker(void *arg)
+{
+  int j;
+
+  for (;;) {
+    pthread_mutex_lock(&lock);
+    j = next_job++;
+    pthread_mutex_unlock(&lock);
+    if (j >= njobs)
+      return NULL;
+    job(j);
+  }
+}
+
+void run_jobs(int n, void (*fn)(int))
+{
+  pthread_t threads[MAX_THREADS];
+  int i, started;
+
+  next_job = 0;
+  njobs = n;
+  job = fn;
+  for (started = 0; started < nthreads - 1 && started < n - 1; started++)
+    if (pthread_create(&threads[started], NULL, worker, NULL))
+      break;
+  worker(NULL);
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+}
+
+/*****************************************************************************/
+static void add_sample(struct piece *p, const struct sample *s)
+{
+  int c;
+
+  if (p->n == p->max) {
+    p->max = p->max ? p->max * 2 : 4096;
+    p->t = xrealloc(p->t, p->max * sizeof(time_t));
+    for (c = 0; c < NCHANNELS; c++)
+      p->v[c] = xrealloc(p->v[c], p->max * sizeof(double));
+  }
+  p->t[p->n] = s->t;
+  for (c = 0; c < NCHANNELS; c++)
+    p->v[c][p->n] = s->v[c];
+  p->n++;
+}
+
+/* fgets(), except that the *npre bytes at pre, read from f before, come
+   first */
+char *get_line(char *buf, int size, FILE *f, char *pre, int *npre)
+{
+  int i = 0;
+
+  while (*npre && i < size - 1) {
+    buf[i] = *pre;
+    memmove(pre, pre + 1, --*npre);
+    if (buf[i++] == '\n')
+      break;
+  }
+  buf[i] = '\0';
+  if (i && (buf[i - 1] == '\n' || i == size - 1))
+    return buf;
+  if (!fgets(buf + i, size - i, f))
+    return i ? buf : NULL;
+  return buf;
+}
+
+/* Reads the lines that start inside the piece's byte range, or the blocks
+   of a history */
+void load_piece(int j)
+{
+  struct piece *p = &pieces[j];
+  struct hist_block *b;
+  struct hist_reader r;
+  struct sample s;
+  char line[512];
+  long pos = p->start;
+  int c, res, none = 0;
+  FILE *f;
+
+  if (!strcmp(p->filename, "-"))
+    f = stdin;
+  else if (!(f = fopen(p->filename, "rb"))) {
+    perror(p->filename);
+    exit(1);
+  }
+  if (p->history) {
+    b = xrealloc(NULL, sizeof(*b));
+    if (f != stdin)            /* plan_pieces() has read stdin's */
+      hist_file_check_header(f);
+    while (hist_block_read(f, b) == 0) {
+      hist_reader_init(&r, b);
+      while ((res = hist_reader_next(&r, &s)) > 0)
+	add_sample(p, &s);
+      if (res < 0)
+	fprintf(stderr, "%s: damaged block, skipping the rest of it\n",
+		p->filename);
+    }
+    free(b);
+  } else {
+    /* Whoever has the byte before us reads the line it is in */
+    if (pos > 0) {
+      fseek(f, pos - 1, SEEK_SET);
+      while ((c = getc(f)) != EOF && c != '\n')
+	pos++;
+    }
+    while ((p->end < 0 || pos < p->end)
+	   && get_line(line, sizeof(line), f, stdin_magic,
+		       f == stdin ? &stdin_nmagic : &none)) {
+      pos += strlen(line);
+      switch (parse_log_line(line, &s)) {
+      case 1:
+	s.t = 0;
+	/* fall through */
+      case 2:
+	add_sample(p, &s);
+      }
+    }
+  }
+  if (f != stdin)
+    fclose(f);
+}
+
+/* Splits each file into pieces: a history is one piece, a log one piece
+   per CHUNK_BYTES. Stdin is one piece either way. */
+void plan_pieces(int nfiles, char **files)
+{
+  struct stat st;
+  long off;
+  int i, history;
+  FILE *f;
+
+  for (i = 0; i < nfiles; i++) {
+    history = 0;
+    st.st_size = 0;
+    if (strcmp(files[i], "-")) {
+      if (!(f = fopen(files[i], "rb")) || fstat(fileno(f), &st)) {
+	perror(files[i]);
+	exit(1);
+      }
+      history = !hist_file_check_header(f);
+      fclose(f);
+    } else {
+      /* Look for the history header by hand, as stdin can't be rewound */
+      stdin_nmagic = fread(stdin_magic, 1, HIST_FILE_MAGIC_LEN, stdin);
+      history = stdin_nmagic == HIST_FILE_MAGIC_LEN
+	&& !memcmp(stdin_magic, HIST_FILE_MAGIC, HIST_FILE_MAGIC_LEN);
+      if (history)
+	stdin_nmagic = 0;
+    }
+    off = 0;
+    do {
+      pieces = xrealloc(pieces, (npieces + 1) * sizeof(*pieces));
+      memset(&pieces[npieces], 0, sizeof(*pieces));
+      pieces[npieces].filename = files[i];
+      pieces[npieces].history = history;
+      pieces[npieces].start = off;
+      pieces[npieces].end = -1;
+      if (!history && off + CHUNK_BYTES < st.st_size)
+	pieces[npieces].end = off + CHUNK_BYTES;
+      off += CHUNK_BYTES;
+      npieces++;
+    } while (!history && off < st.st_size);
+  }
+}
+
+/*****************************************************************************/
+/* The kernels. Both skip NO_READING and count readings below lo and
+   above hi. */
+static void partial_init(struct partial *p)
+{
+  p->min = HUGE_VAL;
+  p->max = -HUGE_VAL;
+  p->sum = 0;
+  p->n = p->below = p->above = 0;
+}
+
+static void partial_merge(struct partial *to, const struct partial *from)
+{
+  if (from->min < to->min)
+    to->min = from->min;
+  if (from->max > to->max)
+    to->max = from->max;
+  to->sum += from->sum;
+  to->n += from->n;
+  to->below += from->below;
+  to->above += from->above;
+}
+
+/* One reading at a time; the baseline the other is measured against */
+void stats_scalar(const double *v, long n, double lo, double hi,
+		  struct partial *p)
+{
+  long i;
+  double x;
+
+  partial_init(p);
+  for (i = 0; i < n; i++) {
+    x = v[i];
+    if (x == NO_READING)
+      continue;
+    p->n++;
+    p->sum += x;
+    if (x < p->min)
+      p->min = x;
+    if (x > p->max)
+      p->max = x;
+    if (x < lo)
+      p->below++;
+    else if (x > hi)
+      p->above++;
+  }
+}
+
+#ifdef __SSE2__
+/* Four readings at a time in two pairs of lanes, with the missing ones
+   masked out rather than branched over. The counts are kept as doubles,
+   which is exact far beyond any log. */
+void stats_vector(const double *v, long n, double lo, double hi,
+		  struct partial *p)
+{
+  const __m128d none = _mm_set1_pd(NO_READING), one = _mm_set1_pd(1);
+  const __m128d big = _mm_set1_pd(HUGE_VAL), small = _mm_set1_pd(-HUGE_VAL);
+  const __m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi);
+  __m128d sum[2], cnt[2], mn[2], mx[2], below[2], above[2];
+  __m128d x, ok;
+  double a[2], b[2];
+  struct partial tail;
+  long i;
+  int k;
+
+  for (k = 0; k < 2; k++) {
+    sum[k] = cnt[k] = below[k] = above[k] = _mm_setzero_pd();
+    mn[k] = big;
+    mx[k] = small;
+  }
+  for (i = 0; i + 4 <= n; i += 4)
+    for (k = 0; k < 2; k++) {
+      x = _mm_loadu_pd(v + i + 2 * k);
+      ok = _mm_cmpneq_pd(x, none);
+      sum[k] = _mm_add_pd(sum[k], _mm_and_pd(ok, x));
+      cnt[k] = _mm_add_pd(cnt[k], _mm_and_pd(ok, one));
+      mn[k] = _mm_min_pd(mn[k], _mm_or_pd(_mm_and_pd(ok, x),
+					  _mm_andnot_pd(ok, big)));
+      mx[k] = _mm_max_pd(mx[k], _mm_or_pd(_mm_and_pd(ok, x),
+					  _mm_andnot_pd(ok, small)));
+      below[k] = _mm_add_pd(below[k], _mm_and_pd(_mm_cmplt_pd(x, vlo),
+						 _mm_and_pd(ok, one)));
+      above[k] = _mm_add_pd(above[k], _mm_and_pd(_mm_cmpgt_pd(x, vhi),
+						 _mm_and_pd(ok, one)));
+    }
+
+  _mm_storeu_pd(a, _mm_add_pd(sum[0], sum[1]));
+  p->sum = a[0] + a[1];
+  _mm_storeu_pd(a, _mm_add_pd(cnt[0], cnt[1]));
+  p->n = (long)(a[0] + a[1]);
+  _mm_storeu_pd(a, _mm_add_pd(below[0], below[1]));
+  p->below = (long)(a[0] + a[1]);
+  _mm_storeu_pd(a, _mm_add_pd(above[0], above[1]));
+  p->above = (long)(a[0] + a[1]);
+  _mm_storeu_pd(a, _mm_min_pd(mn[0], mn[1]));
+  _mm_storeu_pd(b, _mm_max_pd(mx[0], mx[1]));
+  p->min = a[0] < a[1] ? a[0] : a[1];
+  p->max = b[0] > b[1] ? b[0] : b[1];
+
+  stats_scalar(v + i, n - i, lo, hi, &tail);
+  partial_merge(p, &tail);
+}
+#else
+/* Without SSE2, the same thing without branches for the compiler to
+   vectorise if it can */
+void stats_vector(const double *v, long n, double lo, double hi,
+		  struct partial *p)
+{
+  double sum = 0, mn = HUGE_VAL, mx = -HUGE_VAL, x;
+  long i, cnt = 0, below = 0, above = 0;
+  int ok;
+
+  for (i = 0; i < n; i++) {
+    x = v[i];
+    ok = x != NO_READING;
+    sum += ok ? x : 0;
+    cnt += ok;
+    mn = ok && x < mn ? x : mn;
+    mx = ok && x > mx ? x : mx;
+    below += ok && x < lo;
+    above += ok && x > hi;
+  }
+  p->sum = sum;
+  p->n = cnt;
+  p->min = mn;
+  p->max = mx;
+  p->below = below;
+  p->above = above;
+}
+#endif
+
+/* One column of one piece */
+void aggregate_column(int j)
+{
+  int c = j % NCHANNELS;
+
+  kernel(pieces[j / NCHANNELS].v[c], pieces[j / NCHANNELS].n,
+	 lim.lo[c], lim.hi[c], &partials[j]);
+}
+
+void aggregate(kernel_fn k)
+{
+  int i, c;
+
+  kernel = k;
+  run_jobs(npieces * NCHANNELS, aggregate_column);
+  for (c = 0; c < NCHANNELS; c++) {
+    partial_init(&totals[c]);
+    for (i = 0; i < npieces; i++)
+      partial_merge(&totals[c], &partials[i * NCHANNELS + c]);
+  }
+}
+
+/*****************************************************************************/
+/* Leaves the kth smallest of a[0..n-1] at a[k], with nothing larger
+   before it and nothing smaller after it */
+static void select_kth(double *a, long n, long k)
+{
+  long lo = 0, hi = n - 1, i, j;
+  double pivot, t;
+
+  while (lo < hi) {
+    pivot = a[lo + (hi - lo) / 2];
+    i = lo;
+    j = hi;
+    while (i <= j) {
+      while (a[i] < pivot)
+	i++;
+      while (a[j] > pivot)
+	j--;
+      if (i <= j) {
+	t = a[i];
+	a[i++] = a[j];
+	a[j--] = t;
+      }
+    }
+    if (k <= j)
+      hi = j;
+    else if (k >= i)
+      lo = i;
+    else
+      return;
+  }
+}
+
+/* Nearest rank percentiles of one channel over every piece */
+void percentile_column(int c)
+{
+  double *a;
+  long n = 0, i, k, done = 0;
+  int j;
+
+  if (!totals[c].n)
+    return;
+  a = xrealloc(NULL, totals[c].n * sizeof(double));
+  for (j = 0; j < npieces; j++)
+    for (i = 0; i < pieces[j].n; i++)
+      if (pieces[j].v[c][i] != NO_READING)
+	a[n++] = pieces[j].v[c][i];
+  /* The percentiles are in order, so each search starts where the last
+     one left off */
+  for (j = 0; j < npercentiles; j++) {
+    k = (long)ceil(percentiles[j] / 100 * n) - 1;
+    if (k < done)
+      k = done;
+    if (k >= n)
+      k = n - 1;
+    select_kth(a + done, n - done, k - done);
+    results[c][j] = a[k];
+    done = k;
+  }
+  free(a);
+}
+
+/*****************************************************************************/
+/* Runs one channel through the predictor, reading by reading and file by
+   file, as InsertLm() would have. An alarm is on while the reading is
+   within limits but the trend says it will cross them within horizon. */
+void replay_column(int c)
+{
+  struct replay *r = &replays[c];
+  struct trend tr;
+  const char *file = NULL;
+  double lo = lim.lo[c], hi = lim.hi[c], v, start = now();
+  time_t t, alarm_since = -1;
+  int beyond, was_beyond = -1;
+  long i;
+  int j;
+
+  for (j = 0; j < npieces; j++) {
+    if (pieces[j].filename != file) {
+      file = pieces[j].filename;
+      trend_reset(&tr);
+      alarm_since = -1;
+      was_beyond = -1;
+    }
+    for (i = 0; i < pieces[j].n; i++) {
+      v = pieces[j].v[c][i];
+      t = pieces[j].t[i];
+      trend_update(&tr, t, v);
+      if (v == NO_READING)
+	continue;
+      beyond = v < lo || v > hi;
+      if (beyond) {
+	if (was_beyond == 0) {
+	  r->crossings++;
+	  if (alarm_since >= 0) {
+	    r->predicted++;
+	    r->lead += t - alarm_since;
+	  }
+	}
+	alarm_since = -1;
+      } else if (trend_crossing(&tr, lo, hi, horizon) >= 0) {
+	if (alarm_since < 0)
+	  alarm_since = t;
+      } else if (alarm_since >= 0) {
+	r->false_alarms++;
+	alarm_since = -1;
+      }
+      was_beyond = beyond;
+    }
+  }
+  r->seconds = now() - start;
+}
+
+void report_replay(long total)
+{
+  double seconds = 0;
+  int c;
+
+  printf("\npredictive alarm, %g s horizon:\n", horizon);
+  printf("channel  crossings  warned  missed  mean warning  false alarms\n");
+  for (c = 0; c < NCHANNELS; c++) {
+    seconds += replays[c].seconds;
+    if (!totals[c].n || (lim.lo[c] == -HUGE_VAL && lim.hi[c] == HUGE_VAL))
+      continue;
+    printf("%-7s %10ld %7ld %7ld", channel_names[c], replays[c].crossings,
+	   replays[c].predicted, replays[c].crossings - replays[c].predicted);
+    if (replays[c].predicted)
+      printf(" %11.1fs", replays[c].lead / replays[c].predicted);
+    else
+      printf(" %12s", "-");
+    printf(" %13ld\n", replays[c].false_alarms);
+  }
+  printf("%.1f ns per reading, trend update and check included\n",
+	 seconds * 1e9 / ((double)total * NCHANNELS));
+}
+
+/*****************************************************************************/
+static int compare_doubles(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+void parse_percentiles(char *arg)
+{
+  char *tok;
+
+  npercentiles = 0;
+  for (tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+    if (npercentiles == MAX_PERCENTILES)
+      usage();
+    percentiles[npercentiles] = atof(tok);
+    if (percentiles[npercentiles] <= 0 || percentiles[npercentiles] > 100)
+      usage();
+    npercentiles++;
+  }
+  qsort(percentiles, npercentiles, sizeof(double), compare_doubles);
+}
+
+void parse_limit(char *arg)
+{
+  char *colon = strchr(arg, ':');
+  int c;
+
+  if (!colon)
+    usage();
+  *colon = '\0';
+  if ((c = channel_lookup(arg)) < 0) {
+    fprintf(stderr, "%s: no channel called %s\n", ProgName, arg);
+    exit(1);
+  }
+  if (sscanf(colon + 1, "%lf:%lf", &lim.lo[c], &lim.hi[c]) != 2)
+    usage();
+}
+
+void report(void)
+{
+  char label[16];
+  int c, j;
+
+  printf("channel  readings       min      mean       max");
+  for (j = 0; j < npercentiles; j++) {
+    snprintf(label, sizeof(label), "p%g", percentiles[j]);
+    printf("  %9s", label);
+  }
+  printf("    below    above\n");
+  for (c = 0; c < NCHANNELS; c++) {
+    if (!totals[c].n)
+      continue;
+    printf("%-7s %9ld %9.2f %9.2f %9.2f", channel_names[c], totals[c].n,
+	   totals[c].min, totals[c].sum / totals[c].n, totals[c].max);
+    for (j = 0; j < npercentiles; j++)
+      printf("  %9.2f", results[c][j]);
+    printf(" %8ld %8ld\n", totals[c].below, totals[c].above);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  double start, t;
+  long total = 0;
+  int i, scalar = 0, bench = 0, wanted;
+
+  ProgName = argv[0];
+  default_limits(&lim);
+  nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+  for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+    switch (argv[i][1]) {
+    case 'p':
+      if (++i >= argc) usage();
+      parse_percentiles(argv[i]);
+      break;
+    case 'l':
+      if (++i >= argc) usage();
+      parse_limit(argv[i]);
+      break;
+    case 'H':
+      if (++i >= argc || (horizon = atof(argv[i])) <= 0) usage();
+      break;
+    case 't':
+      if (++i >= argc || (nthreads = atoi(argv[i])) < 1) usage();
+      break;
+    case 's':
+      scalar = 1;
+      break;
+    case 'b':
+      bench = 1;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (i >= argc)
+    usage();
+  if (nthreads < 1)
+    nthreads = 1;
+  if (nthreads > MAX_THREADS)
+    nthreads = MAX_THREADS;
+
+  plan_pieces(argc - i, argv + i);
+  start = now();
+  run_jobs(npieces, load_piece);
+  t = now() - start;
+  for (i = 0; i < npieces; i++)
+    total += pieces[i].n;
+  if (!total) {
+    fprintf(stderr, "%s: no samples\n", ProgName);
+    exit(1);
+  }
+  if (bench)
+    fprintf(stderr, "%ld samples in %d pieces loaded in %.2f s "
+	    "(%.0f samples/s)\n", total, npieces, t, total / t);
+  partials = xrealloc(NULL, npieces * NCHANNELS * sizeof(*partials));
+
+  if (bench) {
+    /* The baseline: the scalar kernel on one thread */
+    wanted = nthreads;
+    nthreads = 1;
+    start = now();
+    aggregate(stats_scalar);
+    t = now() - start;
+    fprintf(stderr, "scalar, 1 thread:   %8.1f ms %12.0f samples/s\n",
+	    t * 1000, total / t);
+    nthreads = wanted;
+    start = now();
+    aggregate(stats_scalar);
+    t = now() - start;
+    fprintf(stderr, "scalar, %2d threads: %8.1f ms %12.0f samples/s\n",
+	    nthreads, t * 1000, total / t);
+    start = now();
+    aggregate(stats_vector);
+    t = now() - start;
+    fprintf(stderr, "vector, %2d threads: %8.1f ms %12.0f samples/s\n",
+	    nthreads, t * 1000, total / t);
+  }
+  aggregate(scalar ? stats_scalar : stats_vector);
+
+  start = now();
+  run_jobs(NCHANNELS, percentile_column);
+  if (bench)
+    fprintf(stderr, "percentiles:        %8.1f ms\n", (now() - start) * 1000);
+
+  if (horizon > 0)
+    run_jobs(NCHANNELS, replay_column);
+
+  report();
+  if (horizon > 0)
+    report_replay(total);
+  return 0;
+}